@@ -1,101 +1,900 @@
 #include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <cstdio>
 #include <cstring>
+#include <thread>
+#include <unistd.h>
 
 #include "parser.h"
+#include "RegAlloc.h"
+#include "Peephole.h"
+#include "Frame.h"
+#include "Layout.h"
+#include "Range.h"
+#include "ModRef.h"
+#include "Writer.h"
+#include "Linker.h"
+#include "Scheduler.h"
+#include "Cache.h"
+#include "Hash.h"
+#include "Server.h"
+#include "Profiler.h"
+#include "MemoryReport.h"
 
 const char* usage = R"(
 usage: ni-gen [options] file
+       ni-gen --batch [-workers=<N>] [options] files
+       ni-gen --server <socket> [-workers=<N>]
+       ni-gen --connect <socket> [options] file
 
 Options:
     -o <file>        Place the output into <file>.
     -asm [<file>]    Output generated assembly. If file not provided : into a console.
     -ir [<file>]     Output generated IR code. If file not provided : into a console.
+    -regs=<N>        Allocate registers into N physical registers (at least 3).
+    -fregs=<N>       Number of the physical float registers for the allocation (default: same as -regs).
+    -regalloc=<alg>  Algorithm of the register allocation: linear (default) or color.
+    -regalloc-report Print spill counts and instruction counts of each function after the allocation.
+    -callconv=<conv> Calling convention: regs (default) passes the first 4 arguments of each register file
+                     and the result in registers, stack passes everything through the stack.
+    -frameless       Omit the unused frames and address the frame of leaf functions by SP. With -regs
+                     also keeps the locals, whose address is not taken, in registers.
+    -stack-coloring  Let the locals and the spilled registers, which are not alive at the same time,
+                     share the words of the frame.
+    -funroll-loops=<N> Unroll the counted loops N times, the loops with few iterations completely.
+    -funroll-budget=<N> Number of the AST nodes, which the unrolled body of the loop may have (default: 64).
+    -peephole        Run the peephole optimiser over the generated assembly.
+    -peephole-report Print how many times each peephole rule has fired.
+    -fstream         Compile the program function after function and free each one, when it is written.
+                     The analyses do not look over the functions. -asm needs a file then.
+    -threads=<N>     Generate and optimise the code of the functions by N threads. Output does not depend
+                     on N. Cannot be used with -fstream.
+    -fcache=<dir>    Keep the compiled functions in <dir> and take the unchanged ones from it. Implies -fstream.
+    -fcache-report   Print how many functions have been taken from the cache.
+    -ftime-report    Print the wall and the CPU time of each phase in milliseconds. With -threads the times
+                     of the threads are added up.
+    -ftime-trace=<file> Write the phases and the functions as the trace events of Chrome into <file>.
+    -fmem-report     Print the nodes of the AST, the types, the IR values and the T86 code, which live after
+                     each phase, with the peak resident memory in kB, then the count and the bytes by class.
+
+Batch:
+    --batch          Compile many programs (the arguments ending with .go) by -workers=<N> threads (default:
+                     number of the cores). Output of each goes next to it (.go replaced by .t86), the options
+                     are shared. @<file> is replaced by the arguments in <file>. Prints the time of each program.
+
+Server:
+    --server <socket> Compile the requests, which come to the Unix domain <socket>, until stopped. The entries
+                     of the caches stay in the memory between the requests.
+    -workers=<N>     Number of the requests compiled at the same time (default: number of the cores).
+    --connect <socket> Let the server at <socket> compile the file with the options. Relative paths are
+                     taken from the current directory.
 )";
 
-void incorrect_args(){
+int incorrect_args(){
     std::cout << usage << std::endl;
-    exit(EXIT_FAILURE);
+    return EXIT_FAILURE;
 }
 
-int main(int argc, char* argv[]) {
+struct Options {
+    // 0 -- do not allocate registers, use unbounded number of them
+    std::size_t numberOfRegisters = 0, numberOfFloatRegisters = 0;
+
+    bool colorRegisters = false, regallocReport = false;
+
+    bool peephole = false, peepholeReport = false;
+
+    bool stackConvention = false, frameless = false, stackColoring = false;
+
+    // 1 -- loops are not unrolled
+    std::size_t unrollFactor = 1, unrollBudget = 64;
+
+    bool streaming = false;
+
+    // 0 -- the code is generated at once, otherwise function by function in the threads
+    std::size_t threads = 0;
+
+    // empty -- functions are not cached
+    std::string cacheDir;
+
+    bool cacheReport = false;
+
+    bool timeReport = false;
+
+    // empty -- trace is not written
+    std::string timeTrace;
+
+    // phases of the compilation are measured by it, if it is set
+    Profiler *profiler = nullptr;
+
+    bool memReport = false;
+
+    // objects are counted after each phase by it, if it is set
+    MemoryReport *memory = nullptr;
 
     bool asmPrint = false, irPrint = false;
 
-    std::string inputF,outputF,asmF,irF;
+    std::string outputF, asmF, irF;
 
-    // command line arguments parse
-    if (argc < 2)
-        incorrect_args();
+    // console of the request (the connection to the client in the compile server)
+    std::ostream *console = &std::cout;
 
+    int consoleDescriptor = STDOUT_FILENO;
 
-    for (auto i = 1; i < argc - 1; ++i) {
-        if (strcmp(argv[i],"-o") == 0) {
-            i++;
-            if (i >= argc - 1)
-                incorrect_args();
-            outputF = argv[i];
-        } else if (strcmp(argv[i],"-asm") == 0) {
-            asmPrint = true;
-            if (i + 2 < argc && argv[i+1][0] != '-')
-                asmF = argv[i++];
-        } else if (strcmp(argv[i],"-ir") == 0) {
-            irPrint = true;
-            if (i + 2 < argc && argv[i+1][0] != '-')
-                irF = argv[i++];
-        } else {
-            std::cout << usage << std::endl;
-            return EXIT_FAILURE;
+    // buffer of the console stream. Line ends do not flush it, so it goes out before the other console output
+    Writer *consoleWriter = nullptr;
+
+    // entries of the function caches shared by the requests of the compile server
+    T86::FunctionCache::Memory *cacheMemory = nullptr;
+};
+
+// the console output already in the stream has to go before the output, which is written right into the descriptor
+void flushConsole(const Options &options) {
+    options.console->flush();
+    if (options.consoleWriter)
+        options.consoleWriter->flush();
+}
+
+// objects, which live after the phase, and the code of T86, if there is one already
+void measure(const Options &options, std::string_view phase, T86::T86Program *program = nullptr) {
+    if (!options.memory)
+        return;
+    std::size_t instructions = 0, operands = 0, bytes = 0;
+    if (program) {
+        auto &code = program->getInstructions();
+        instructions = code.size();
+        for (auto &i: code)
+            operands += (i.getFirst() != nullptr) + (i.getSecond() != nullptr);
+        bytes = code.capacity() * sizeof(T86::Instruction) + program->getData().capacity() * sizeof(T86::Operand);
+    }
+    options.memory->snapshot(phase, instructions, operands, bytes);
+}
+
+/**
+ * Passes over the generated target code, which are chosen by the options. The same passes run over each
+ * part of the streamed program, their reports cover all the parts
+ */
+struct Backend {
+    explicit Backend(const Options &new_options) : options(new_options) {}
+
+    const Options &options;
+
+    std::unique_ptr<T86::RegisterAllocator> allocator;
+
+    T86::Peephole optimiser;
+
+    T86::FrameOptimiser frame;
+
+    void prepare(T86::Context &T86ctx) {
+        T86ctx.profiler = options.profiler;
+        if (options.stackConvention)
+            return;
+
+        // two registers of each file have to stay for the spilled values
+        auto &convention = T86ctx.getProgram().getCallingConvention();
+        convention.registers = convention.float_registers = 4;
+        if (options.numberOfRegisters) {
+            convention.registers = std::min<std::size_t>(convention.registers, options.numberOfRegisters - 2);
+            convention.float_registers = std::min<std::size_t>(convention.float_registers,
+                                                               options.numberOfFloatRegisters - 2);
         }
     }
 
-    inputF = argv[argc - 1];
+    void run(T86::T86Program &program) {
+        Profiler::Phase phase(options.profiler, "backend");
+
+        // without the allocation registers are not preserved over the calls
+        if (options.frameless && options.numberOfRegisters) {
+            Profiler::Phase pass(options.profiler, "slot promotion");
+            frame.promoteSlots(program);
+        }
+
+        if (options.numberOfRegisters) {
+            Profiler::Phase pass(options.profiler, "register allocation");
+            if (!allocator && options.colorRegisters)
+                allocator = std::make_unique<T86::GraphColoringAllocator>(options.numberOfRegisters,
+                                                                          options.numberOfFloatRegisters);
+            else if (!allocator)
+                allocator = std::make_unique<T86::LinearScanAllocator>(options.numberOfRegisters,
+                                                                       options.numberOfFloatRegisters);
+            allocator->run(program, options.profiler);
+        }
 
+        if (options.stackColoring) {
+            Profiler::Phase pass(options.profiler, "stack coloring");
+            frame.shareSlots(program);
+        }
 
+        if (options.peephole) {
+            Profiler::Phase pass(options.profiler, "peephole");
+            optimiser.run(program);
+        }
 
+        if (options.frameless) {
+            Profiler::Phase pass(options.profiler, "frame omission");
+            frame.omitFrames(program);
+        }
+    }
 
-    try {
-        Parser p(inputF);
-        auto root = p.parse();
-        if (!root)
-            return 0;
+    // adds the reports of the backend, which has run over the code after this one
+    void merge(const Backend &other) {
+        if (allocator && other.allocator)
+            allocator->merge(*other.allocator);
+        optimiser.merge(other.optimiser);
+    }
 
-        AST::Context ctx;
-        root->checker(ctx);
+    void report() {
+        if (options.regallocReport && allocator)
+            allocator->printReport(*options.console);
+        if (options.peepholeReport)
+            optimiser.printReport(*options.console);
+    }
+};
 
-        auto IRctx = ctx.createIRContext();
-        auto IR = root->generateIR(IRctx);
+// generates the code of each function separately by the threads. Parts are put together in the order of the
+// functions, so the code is the same as the one generated at once
+void generateParallel(IR::IRProgram &IR, T86::Context &T86ctx, Backend &backend) {
+    auto &options = backend.options;
 
-        if (irPrint) {
-            if (irF.empty())
-                IR->print(std::cout);
-            else {
-                std::ofstream file(irF,std::ofstream::out);
-                IR->print(file);
+    {
+        Profiler::Phase phase(options.profiler, "T86 lowering");
+        IR.generateEntry(T86ctx);
+        T86ctx.finishCallsAndJmps();
+    }
+    backend.run(T86ctx.getProgram());
+
+    auto &functions = *IR.getLinkToFunctions();
+    std::vector<T86::Context> parts(functions.size());
+    std::vector<std::unique_ptr<Backend>> backends;
+    for (std::size_t i = 0; i < functions.size(); ++i)
+        backends.emplace_back(std::make_unique<Backend>(options));
+
+    // phases of the threads belong to the phases of this one
+    auto profiler = options.profiler;
+    Scheduler scheduler(options.threads);
+    std::vector<std::function<void()>> tasks;
+    {
+        Profiler::Phase phase(profiler, "T86 lowering");
+        auto lowering = profiler ? profiler->current() : nullptr;
+        for (std::size_t i = 0; i < functions.size(); ++i)
+            tasks.emplace_back([&, i]() {
+                Profiler::Attach attach(profiler, lowering);
+                Profiler::Span span(profiler, dynamic_cast<IR::IRFunc *>(functions[i].get())->getName());
+                backends[i]->prepare(parts[i]);
+                for (auto &func: functions)
+                    if (auto callee = dynamic_cast<IR::IRFunc *>(func.get()); callee && callee->returnsValue())
+                        parts[i].addReturningFunction(callee->getName());
+                functions[i]->generateT86(parts[i]);
+                parts[i].finishCallsAndJmps();
+            });
+        scheduler.run(tasks);
+    }
+
+    // the allocation has to know the arguments of the functions from the other parts
+    std::map<std::string, T86::FunctionInfo> called;
+    for (auto &part: parts)
+        for (auto &info: part.getProgram().getFunctions())
+            called.emplace(info.name, info);
+    for (auto &part: parts)
+        for (auto &external: part.getProgram().getExternals())
+            if (auto info = called.find(external.name); info != called.end())
+                external = info->second;
+
+    tasks.clear();
+    auto outer = profiler ? profiler->current() : nullptr;
+    for (std::size_t i = 0; i < functions.size(); ++i)
+        tasks.emplace_back([&, i]() {
+            Profiler::Attach attach(profiler, outer);
+            Profiler::Span span(profiler, dynamic_cast<IR::IRFunc *>(functions[i].get())->getName());
+            backends[i]->run(parts[i].getProgram());
+        });
+    scheduler.run(tasks);
+
+    for (std::size_t i = 0; i < functions.size(); ++i) {
+        T86ctx.getProgram().append(std::move(parts[i].getProgram()));
+        if (!backend.allocator && backends[i]->allocator)
+            backend.allocator = std::move(backends[i]->allocator);
+        else
+            backend.merge(*backends[i]);
+    }
+    T86ctx.getProgram().linkExternals();
+}
+
+// compiles the whole program at once
+void compile(AST::Program &root, Backend &backend) {
+    auto &options = backend.options;
+
+    auto profiler = options.profiler;
+
+    AST::Context ctx;
+    {
+        Profiler::Phase phase(profiler, "checking");
+        root.checker(ctx);
+    }
+    measure(options, "checking");
+
+    auto IRctx = ctx.createIRContext();
+    IRctx.unroll_factor = options.unrollFactor;
+    IRctx.unroll_budget = options.unrollBudget;
+    IR::IRProgram *IR;
+    {
+        Profiler::Phase phase(profiler, "IR generation");
+        IR = dynamic_cast<IR::IRProgram *>(root.generateIR(IRctx));
+    }
+    measure(options, "IR generation");
+
+    {
+        Profiler::Phase phase(profiler, "IR optimisation");
+
+        // structures, which are only read by the called function, are not copied
+        {
+            Profiler::Phase pass(profiler, "mod-ref analysis");
+            IR::ModRefAnalysis modref;
+            modref.run(*IR);
+        }
+
+        // intervals of the integer values decide the comparisons and the casts
+        {
+            Profiler::Phase pass(profiler, "range analysis");
+            IR::RangeAnalysis ranges;
+            ranges.run(*IR);
+        }
+
+        // the likely successor of each block follows it
+        {
+            Profiler::Phase pass(profiler, "block layout");
+            IR::BlockLayout layout;
+            layout.run(*IR);
+        }
+    }
+    measure(options, "IR optimisation");
+
+    if (options.irPrint) {
+        Profiler::Phase phase(profiler, "IR printing");
+        flushConsole(options);
+        auto writer = options.irF.empty() ? std::make_unique<Writer>(options.consoleDescriptor)
+                                          : std::make_unique<Writer>(options.irF);
+        std::ostream stream(writer.get());
+        IR->print(stream);
+    }
+
+    auto T86ctx = IRctx.createT86Context();
+    backend.prepare(T86ctx);
+    if (options.threads) {
+        generateParallel(*IR, T86ctx, backend);
+    } else {
+        {
+            Profiler::Phase phase(profiler, "T86 lowering");
+            IR->generateT86(T86ctx);
+        }
+        measure(options, "T86 lowering", &T86ctx.getProgram());
+        backend.run(T86ctx.getProgram());
+    }
+    measure(options, "backend", &T86ctx.getProgram());
+    backend.report();
+
+    Profiler::Phase phase(profiler, "emission");
+    if (options.asmPrint) {
+        flushConsole(options);
+        auto writer = options.asmF.empty() ? std::make_unique<Writer>(options.consoleDescriptor)
+                                           : std::make_unique<Writer>(options.asmF);
+        T86ctx.print(*writer);
+    }
+
+    if (!options.outputF.empty()) {
+        Writer writer(options.outputF);
+        T86ctx.print(writer);
+    }
+    measure(options, "emission", &T86ctx.getProgram());
+}
+
+// compiles the program function after function. Each function is checked, optimised and written out, then
+// its AST, IR and code are freed. The calls between the functions are linked in the output
+void compileStreamed(AST::Program &root, Backend &backend) {
+    auto &options = backend.options;
+
+    // calls of the functions, which are written already, cannot be filled in the console
+    if (options.asmPrint && options.asmF.empty())
+        throw std::invalid_argument("ERROR. Streamed assembly has to be written into a file.");
+
+    auto profiler = options.profiler;
+
+    AST::Context ctx;
+    {
+        Profiler::Phase phase(profiler, "checking");
+        root.declare(ctx);
+    }
+    measure(options, "checking");
+
+    auto IRctx = ctx.createIRContext();
+    IRctx.unroll_factor = options.unrollFactor;
+    IRctx.unroll_budget = options.unrollBudget;
+    {
+        Profiler::Phase phase(profiler, "IR generation");
+        root.generateGlobalsIR(IRctx);
+    }
+    measure(options, "IR generation");
+    auto IR = IRctx.program.get();
+
+    // callers have to know, which functions return a value, before they are generated
+    std::vector<std::string> returning;
+    for (auto &i: root.getFunctions())
+        if (i->returnsValue())
+            returning.emplace_back(i->getName());
+
+    std::unique_ptr<Writer> irWriter, asmWriter, outWriter;
+    std::unique_ptr<std::ostream> irStream;
+    std::unique_ptr<T86::Linker> asmLinker, outLinker;
+    if (options.irPrint) {
+        flushConsole(options);
+        irWriter = options.irF.empty() ? std::make_unique<Writer>(options.consoleDescriptor)
+                                       : std::make_unique<Writer>(options.irF);
+        irStream = std::make_unique<std::ostream>(irWriter.get());
+    }
+    if (options.asmPrint) {
+        asmWriter = std::make_unique<Writer>(options.asmF);
+        asmLinker = std::make_unique<T86::Linker>(*asmWriter);
+    }
+    if (!options.outputF.empty()) {
+        outWriter = std::make_unique<Writer>(options.outputF);
+        outLinker = std::make_unique<T86::Linker>(*outWriter);
+    }
+
+    // everything else, which the code of each function depends on
+    std::unique_ptr<T86::FunctionCache> cache;
+    Hash common;
+    if (!options.cacheDir.empty()) {
+        cache = std::make_unique<T86::FunctionCache>(options.cacheDir, options.cacheMemory);
+        common.add(root.getDigest());
+        for (auto i: {options.numberOfRegisters, options.numberOfFloatRegisters, options.unrollFactor,
+                      options.unrollBudget})
+            common.add((std::uint64_t) i);
+        for (auto i: {options.colorRegisters, options.peephole, options.stackConvention, options.frameless,
+                      options.stackColoring})
+            common.add((std::uint64_t) i);
+    }
+
+    IR::ModRefAnalysis modref;
+    auto &functions = root.getFunctions();
+    std::string key, name;
+    long long first_value = 0;
+    // the first part is the start of the program with the function, which initialises the globals
+    for (std::size_t i = 0; i <= functions.size(); ++i) {
+        Profiler::Span span(profiler, i ? functions[i - 1]->getName() : "entry");
+        if (i && cache) {
+            Profiler::Phase phase(profiler, "cache");
+            auto digest = common;
+            digest.add(functions[i - 1]->getBodyDigest());
+            // what is known about the functions before
+            for (auto &[callee, read_only]: modref.getSummaries()) {
+                digest.add(callee);
+                for (auto k: read_only)
+                    digest.add((std::uint64_t) k);
+            }
+            // without the allocation the registers are numbered over the whole program
+            if (!options.numberOfRegisters)
+                digest.add((std::uint64_t) IRctx.counter);
+            key = digest.toString();
+            name = functions[i - 1]->getName();
+            first_value = IRctx.counter;
+
+            T86::FunctionCache::Entry entry;
+            if (cache->load(key, entry)) {
+                modref.addSummary(name, entry.read_only);
+                IRctx.counter += entry.values;
+                functions[i - 1].reset();
+                if (asmLinker)
+                    asmLinker->write(entry.code);
+                if (outLinker)
+                    outLinker->write(entry.code);
+                continue;
             }
         }
 
-        auto T86ctx = IRctx.createT86Context();
+        if (i) {
+            {
+                Profiler::Phase phase(profiler, "checking");
+                functions[i - 1]->checker(ctx);
+            }
+            measure(options, "checking");
+            {
+                Profiler::Phase phase(profiler, "IR generation");
+                functions[i - 1]->generateIR(IRctx);
+                functions[i - 1].reset();
+            }
+            measure(options, "IR generation");
+        }
+
+        {
+            Profiler::Phase phase(profiler, "IR optimisation");
+            {
+                Profiler::Phase pass(profiler, "mod-ref analysis");
+                for (auto &func: *IR->getLinkToFunctions())
+                    modref.runStreamed(*dynamic_cast<IR::IRFunc *>(func.get()));
+            }
 
-        IR->generateT86(T86ctx);
+            // the other functions are not known, so the analyses stay inside of the part
+            {
+                Profiler::Phase pass(profiler, "range analysis");
+                IR::RangeAnalysis ranges;
+                ranges.runPart(*IR);
+            }
 
-        if (asmPrint) {
-            if (asmF.empty())
-                T86ctx.print(std::cout);
-            else {
-                std::ofstream file(asmF,std::ofstream::out);
-                T86ctx.print(file);
+            {
+                Profiler::Phase pass(profiler, "block layout");
+                IR::BlockLayout layout;
+                layout.run(*IR);
             }
         }
+        measure(options, "IR optimisation");
+
+        if (options.irPrint) {
+            Profiler::Phase phase(profiler, "IR printing");
+            if (i)
+                IR->printFunctions(*irStream);
+            else
+                IR->print(*irStream);
+        }
+
+        auto T86ctx = IRctx.createT86Context();
+        backend.prepare(T86ctx);
+        for (auto &name: returning)
+            T86ctx.addReturningFunction(name);
+        {
+            Profiler::Phase phase(profiler, "T86 lowering");
+            if (i) {
+                IR->generateFunctions(T86ctx);
+                T86ctx.finishCallsAndJmps();
+            } else
+                IR->generateT86(T86ctx);
+        }
+        measure(options, "T86 lowering", &T86ctx.getProgram());
+        backend.run(T86ctx.getProgram());
+        measure(options, "backend", &T86ctx.getProgram());
+
+        {
+            Profiler::Phase phase(profiler, "emission");
+            if (asmLinker)
+                asmLinker->write(T86ctx.getProgram());
+            if (outLinker)
+                outLinker->write(T86ctx.getProgram());
+        }
+        measure(options, "emission", &T86ctx.getProgram());
+
+        IR->releaseFunctions();
+
+        if (i && cache) {
+            Profiler::Phase phase(profiler, "cache");
+            T86::FunctionCache::Entry entry;
+            entry.code = std::move(T86ctx.getProgram());
+            entry.read_only = modref.getSummaries().at(name);
+            entry.values = IRctx.counter - first_value;
+            cache->store(key, entry);
+        }
+    }
+
+    // IR goes out before the reports
+    if (irStream) {
+        irStream->flush();
+        irWriter->flush();
+    }
+    backend.report();
+    if (cache && options.cacheReport)
+        cache->printReport(*options.console);
+
+    Profiler::Phase phase(profiler, "emission");
+    if (asmLinker)
+        asmLinker->finish();
+    if (outLinker)
+        outLinker->finish();
+}
+
+// relative paths of the request are taken from the directory of the client
+std::string resolve(const std::string &path, const std::string &directory) {
+    if (directory.empty() || path.empty() || path[0] == '/')
+        return path;
+    return directory + "/" + path;
+}
+
+// false, if the options are not correct
+bool parseOptions(const std::vector<std::string> &args, const std::string &directory, Options &options) {
+    auto argc = (int) args.size();
+    for (auto i = 0; i < argc; ++i) {
+        auto arg = args[i].c_str();
+        if (strcmp(arg,"-o") == 0) {
+            i++;
+            if (i >= argc)
+                return false;
+            options.outputF = resolve(args[i], directory);
+        } else if (strcmp(arg,"-asm") == 0) {
+            options.asmPrint = true;
+            if (i + 1 < argc && args[i+1][0] != '-')
+                options.asmF = resolve(args[++i], directory);
+        } else if (strcmp(arg,"-ir") == 0) {
+            options.irPrint = true;
+            if (i + 1 < argc && args[i+1][0] != '-')
+                options.irF = resolve(args[++i], directory);
+        } else if (strncmp(arg,"-regs=",6) == 0) {
+            options.numberOfRegisters = std::strtoull(arg + 6, nullptr, 10);
+            if (options.numberOfRegisters < 3)
+                return false;
+        } else if (strncmp(arg,"-fregs=",7) == 0) {
+            options.numberOfFloatRegisters = std::strtoull(arg + 7, nullptr, 10);
+            if (options.numberOfFloatRegisters < 3)
+                return false;
+        } else if (strncmp(arg,"-funroll-loops=",15) == 0) {
+            options.unrollFactor = std::strtoull(arg + 15, nullptr, 10);
+            if (options.unrollFactor < 1)
+                return false;
+        } else if (strncmp(arg,"-funroll-budget=",16) == 0) {
+            options.unrollBudget = std::strtoull(arg + 16, nullptr, 10);
+        } else if (strcmp(arg,"-regalloc=linear") == 0) {
+            options.colorRegisters = false;
+        } else if (strcmp(arg,"-regalloc=color") == 0) {
+            options.colorRegisters = true;
+        } else if (strcmp(arg,"-regalloc-report") == 0) {
+            options.regallocReport = true;
+        } else if (strcmp(arg,"-callconv=stack") == 0) {
+            options.stackConvention = true;
+        } else if (strcmp(arg,"-callconv=regs") == 0) {
+            options.stackConvention = false;
+        } else if (strcmp(arg,"-frameless") == 0) {
+            options.frameless = true;
+        } else if (strcmp(arg,"-stack-coloring") == 0) {
+            options.stackColoring = true;
+        } else if (strcmp(arg,"-peephole") == 0) {
+            options.peephole = true;
+        } else if (strcmp(arg,"-peephole-report") == 0) {
+            options.peephole = options.peepholeReport = true;
+        } else if (strcmp(arg,"-fstream") == 0) {
+            options.streaming = true;
+        } else if (strncmp(arg,"-fcache=",8) == 0) {
+            options.cacheDir = resolve(arg + 8, directory);
+            options.streaming = true;
+            if (options.cacheDir.empty())
+                return false;
+        } else if (strcmp(arg,"-fcache-report") == 0) {
+            options.cacheReport = true;
+        } else if (strcmp(arg,"-ftime-report") == 0) {
+            options.timeReport = true;
+        } else if (strcmp(arg,"-fmem-report") == 0) {
+            options.memReport = true;
+        } else if (strncmp(arg,"-ftime-trace=",13) == 0) {
+            options.timeTrace = resolve(arg + 13, directory);
+            if (options.timeTrace.empty())
+                return false;
+        } else if (strncmp(arg,"-threads=",9) == 0) {
+            options.threads = std::strtoull(arg + 9, nullptr, 10);
+            if (options.threads < 1)
+                return false;
+        } else {
+            return false;
+        }
+    }
+
+    // streamed functions are compiled one by one
+    if (options.streaming && options.threads)
+        return false;
+
+    if (options.numberOfRegisters && !options.numberOfFloatRegisters)
+        options.numberOfFloatRegisters = options.numberOfRegisters;
+
+    return true;
+}
+
+// false, if the command line is not correct. The input file goes last
+bool parseArguments(const std::vector<std::string> &args, const std::string &directory, Options &options,
+                    std::string &inputF) {
+    if (args.empty() || !parseOptions({args.begin(), args.end() - 1}, directory, options))
+        return false;
+
+    inputF = resolve(args.back(), directory);
+    return true;
+}
+
+// false, if the program has an error. The error is printed into the console
+bool compileFile(const std::string &inputF, Options options) {
+    std::unique_ptr<Profiler> profiler;
+    if (options.timeReport || !options.timeTrace.empty()) {
+        profiler = std::make_unique<Profiler>(!options.timeTrace.empty());
+        options.profiler = profiler.get();
+    }
+
+    // the objects of the compilation are freed before it
+    std::unique_ptr<MemoryReport> memory;
+    if (options.memReport) {
+        memory = std::make_unique<MemoryReport>();
+        options.memory = memory.get();
+    }
+
+    try {
+        std::unique_ptr<AST::Program> root;
+        {
+            Profiler::Phase phase(options.profiler, "parsing");
+            Parser p(inputF, options.profiler);
+            root = p.parse();
+        }
+        measure(options, "parsing");
+        if (!root)
+            return true;
+
+        Backend backend(options);
+        if (options.streaming)
+            compileStreamed(*root, backend);
+        else
+            compile(*root, backend);
+
+        if (options.timeReport)
+            profiler->printReport(*options.console);
+        if (!options.timeTrace.empty())
+            profiler->writeTrace(options.timeTrace);
+        if (options.memReport)
+            memory->printReport(*options.console);
+
+    } catch (std::invalid_argument& e) {
+        *options.console << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// compiles by the command line. The options hold the console of the request
+int run(const std::vector<std::string> &args, const std::string &directory, Options options) {
+    std::string inputF;
+    if (!parseArguments(args, directory, options, inputF)) {
+        *options.console << usage << std::endl;
+        return EXIT_FAILURE;
+    }
 
-        if (!outputF.empty()) {
-            std::ofstream file(outputF, std::ofstream::out);
-            T86ctx.print(file);
+    compileFile(inputF, options);
+    return EXIT_SUCCESS;
+}
+
+// runs the compile server until it is stopped
+int serve(const std::vector<std::string> &args) {
+    if (args.empty() || args.size() > 2)
+        return incorrect_args();
+
+    std::size_t workers = std::max(std::thread::hardware_concurrency(), 1u);
+    if (args.size() == 2) {
+        if (strncmp(args[1].c_str(),"-workers=",9) != 0)
+            return incorrect_args();
+        workers = std::strtoull(args[1].c_str() + 9, nullptr, 10);
+        if (workers < 1)
+            return incorrect_args();
+    }
+
+    T86::FunctionCache::Memory memory;
+    Server server(args[0], workers, [&memory](const std::vector<std::string> &request,
+                                              const std::string &directory, int connection) {
+        Writer writer(connection);
+        std::ostream console(&writer);
+        Options options;
+        options.console = &console;
+        options.consoleDescriptor = connection;
+        options.consoleWriter = &writer;
+        options.cacheMemory = &memory;
+        auto status = run(request, directory, options);
+        flushConsole(options);
+        return status;
+    });
+    server.run();
+    return EXIT_SUCCESS;
+}
+
+// arguments of the response file are separated by the white space. It may name the other response files
+void expandArguments(const std::vector<std::string> &args, std::vector<std::string> &expanded, std::size_t depth = 0) {
+    if (depth > 16)
+        throw std::invalid_argument("ERROR. Response files include each other.");
+    for (auto &arg: args) {
+        if (arg.empty() || arg[0] != '@') {
+            expanded.emplace_back(arg);
+            continue;
         }
+        std::ifstream file(arg.substr(1));
+        if (!file)
+            throw std::invalid_argument("ERROR. Cannot open the response file " + arg.substr(1) + ".");
+        std::vector<std::string> words;
+        for (std::string word; file >> word;)
+            words.emplace_back(std::move(word));
+        expandArguments(words, expanded, depth + 1);
+    }
+}
+
+// compiles the independent programs by the workers. Output of each program goes next to its input,
+// the console output of the programs is printed in their order
+int batch(const std::vector<std::string> &args) {
+    std::vector<std::string> expanded, optionArgs, inputs;
+    expandArguments(args, expanded);
+
+    std::size_t workers = std::max(std::thread::hardware_concurrency(), 1u);
+    for (auto &arg: expanded) {
+        if (arg.starts_with("-workers=")) {
+            workers = std::strtoull(arg.c_str() + 9, nullptr, 10);
+            if (workers < 1)
+                return incorrect_args();
+        } else if (arg.size() > 3 && arg.ends_with(".go"))
+            inputs.emplace_back(arg);
+        else
+            optionArgs.emplace_back(arg);
+    }
+
+    // a single file cannot be shared by the programs
+    Options options;
+    if (inputs.empty() || !parseOptions(optionArgs, "", options) || !options.outputF.empty() ||
+        !options.asmF.empty() || !options.irF.empty() || !options.timeTrace.empty())
+        return incorrect_args();
+
+    T86::FunctionCache::Memory memory;
+    std::vector<std::unique_ptr<std::FILE, int (*)(std::FILE *)>> consoles;
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        consoles.emplace_back(std::tmpfile(), std::fclose);
+        if (!consoles.back())
+            throw std::invalid_argument("ERROR. Cannot create the temporary file.");
+    }
+
+    std::vector<double> times(inputs.size());
+    std::vector<char> failed(inputs.size());
+    std::vector<std::function<void()>> tasks;
+    for (std::size_t i = 0; i < inputs.size(); ++i)
+        tasks.emplace_back([&, i]() {
+            auto start = std::chrono::steady_clock::now();
+            auto descriptor = fileno(consoles[i].get());
+            Writer writer(descriptor);
+            std::ostream console(&writer);
+            auto program = options;
+            program.outputF = inputs[i].substr(0, inputs[i].size() - 3) + ".t86";
+            program.console = &console;
+            program.consoleDescriptor = descriptor;
+            program.consoleWriter = &writer;
+            program.cacheMemory = &memory;
+            failed[i] = !compileFile(inputs[i], program);
+            flushConsole(program);
+            times[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        });
 
+    auto start = std::chrono::steady_clock::now();
+    Scheduler scheduler(workers);
+    scheduler.run(tasks);
+    auto wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 
+    Writer out(STDOUT_FILENO);
+    std::vector<char> buffer(1 << 16);
+    for (auto &i: consoles) {
+        auto descriptor = fileno(i.get());
+        lseek(descriptor, 0, SEEK_SET);
+        for (ssize_t res; (res = read(descriptor, buffer.data(), buffer.size())) > 0;)
+            out << std::string_view(buffer.data(), res);
+    }
+
+    std::ostream report(&out);
+    report << std::fixed << std::setprecision(3);
+    report << "batch file status milliseconds" << std::endl;
+    for (std::size_t i = 0; i < inputs.size(); ++i)
+        report << inputs[i] << ' ' << (failed[i] ? "error " : "ok ") << times[i] << std::endl;
+    report << "wall " << wall << std::endl;
+
+    return std::find(failed.begin(), failed.end(), 1) == failed.end() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+
+    try {
+        if (!args.empty() && args[0] == "--batch")
+            return batch({args.begin() + 1, args.end()});
+        if (!args.empty() && args[0] == "--server")
+            return serve({args.begin() + 1, args.end()});
+        if (!args.empty() && args[0] == "--connect") {
+            if (args.size() < 3)
+                return incorrect_args();
+            return Server::request(args[1], {args.begin() + 2, args.end()});
+        }
     } catch (std::invalid_argument& e) {
         std::cout << e.what() << std::endl;
+        return EXIT_FAILURE;
     }
 
-    return EXIT_SUCCESS;
+    return run(args, "", Options());
 }
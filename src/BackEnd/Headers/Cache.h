@@ -0,0 +1,73 @@
+#ifndef COMPILER_CACHE_H
+#define COMPILER_CACHE_H
+
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "T86Inst.h"
+
+namespace T86 {
+
+    /**
+     * Compiled functions kept on the disk between the runs of the compiler. Each function is stored in its
+     * own file named by the hash of everything, which its code depends on. The entry holds the final code
+     * of the function with the calls left external, so the function taken from the cache is only linked
+     */
+    class FunctionCache {
+    public:
+        struct Entry {
+            // code of the single function
+            T86Program code;
+
+            // arguments, which the function only reads (found by the mod-ref analysis)
+            std::vector<bool> read_only;
+
+            // number of the IR values of the function. Next functions are numbered as without the cache
+            long long values = 0;
+        };
+
+        // entries kept in the memory of the compile server, so each is read from the disk only once.
+        // Shared by the caches of the concurrent requests
+        struct Memory {
+            std::mutex lock;
+
+            // contents of the files by their paths
+            std::map<std::string, std::string> files;
+        };
+
+        // directory is created, if it does not exist
+        explicit FunctionCache(const std::string &, Memory * = nullptr);
+
+        // false, if the entry is not in the cache (or it cannot be read)
+        bool load(const std::string &, Entry &);
+
+        // cache, which cannot be written, is only not filled
+        void store(const std::string &, Entry &);
+
+        // prints how many functions have been found, missed and stored
+        void printReport(std::ostream &);
+
+    private:
+        std::string path(const std::string &);
+
+        static void save(std::ostream &, Entry &);
+
+        static void read(std::istream &, Entry &);
+
+        // contents of the file, found in the memory first
+        bool readFile(const std::string &, std::string &);
+
+        void remember(const std::string &, std::string);
+
+        std::string directory;
+
+        Memory *memory;
+
+        std::size_t hits = 0, misses = 0, stored = 0;
+    };
+}
+
+#endif //COMPILER_CACHE_H
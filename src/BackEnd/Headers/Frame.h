@@ -0,0 +1,56 @@
+#ifndef COMPILER_FRAME_H
+#define COMPILER_FRAME_H
+
+#include <vector>
+#include <map>
+#include <set>
+#include <array>
+
+#include "T86Inst.h"
+
+namespace T86 {
+
+    /**
+     * Optimisations of the stack frame of the functions. Local variables, whose address is never taken,
+     * are kept in the registers instead of the frame. Functions, which do not use their frame anymore,
+     * drop the BP chain, and leaf functions address their frame relative to SP. Objects of the frame,
+     * which are not alive at the same time, share the words
+     */
+    class FrameOptimiser {
+    public:
+        // move the slots of the frame into the virtual registers. Has to run before the register allocation
+        void promoteSlots(T86Program &);
+
+        // place the objects of the frame by their liveness. Runs after the register allocation
+        void shareSlots(T86Program &);
+
+        // remove the BP frame from the functions, which do not need it. Runs on the final code
+        void omitFrames(T86Program &);
+
+    private:
+        /**
+         * Usage of the single slot [BP + k] of the frame
+         */
+        struct Slot {
+            // register files of the values, which are stored and loaded
+            bool general = false, floating = false;
+
+            // slot is accessed by something else, than MOV
+            bool escaped = false;
+        };
+
+        void promoteFunction(T86Program &, std::size_t);
+
+        void shareFunction(T86Program &, std::size_t);
+
+        // marks the instructions of the frame, which are not needed anymore
+        void omitFrame(T86Program &, std::size_t, std::vector<bool> &);
+
+        static bool isFramePointer(Operand *);
+
+        // offset from BP, if the operand is [BP + k]
+        static bool frameOffset(Operand *, long long &);
+    };
+}
+
+#endif //COMPILER_FRAME_H
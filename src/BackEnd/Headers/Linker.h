@@ -0,0 +1,45 @@
+#ifndef COMPILER_LINKER_H
+#define COMPILER_LINKER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "T86Inst.h"
+#include "Writer.h"
+
+namespace T86 {
+
+    /**
+     * Writes the separately generated parts of the program one after another into the single output.
+     * Branches of each part are moved by its place in the output. Calls of the functions, which are
+     * already written, get their address, the others get a blank field, which is filled in, when the
+     * function comes
+     */
+    class Linker {
+    public:
+        explicit Linker(Writer &);
+
+        // writes the code of the part. .data segment is taken from the first part only
+        void write(T86Program &);
+
+        // checks, that all called functions have been written
+        void finish();
+
+    private:
+        // width of the blank field of the call
+        static constexpr std::size_t field = 10;
+
+        Writer &out;
+
+        // number of the instructions written so far
+        std::size_t written = 0;
+
+        std::map<std::string, std::size_t> addresses;
+
+        // places of the blank fields in the output for each function, which is not written yet
+        std::map<std::string, std::vector<std::size_t>> relocations;
+    };
+}
+
+#endif //COMPILER_LINKER_H
@@ -0,0 +1,65 @@
+#ifndef COMPILER_LIVENESS_H
+#define COMPILER_LIVENESS_H
+
+#include <vector>
+#include <map>
+
+#include "T86Inst.h"
+
+namespace T86 {
+
+    /**
+     * Control flow and liveness of the general purpose (or the float) registers inside a single function
+     * of the target code. Positions are relative to the first instruction of the function
+     */
+    struct Liveness {
+        Liveness() = default;
+
+        // analyse the function of the program by its order. Float registers, if the last one is true
+        Liveness(T86Program &, std::size_t, bool = false);
+
+        // number of the register of the analysed file in the operand (or in its address). -1 if there is none
+        long long registerNumber(Operand *);
+
+        // dense number of the register inside the function. -1 if it is not a register of the analysed file
+        long long denseNumber(Operand *);
+
+        std::size_t denseNumber(std::size_t);
+
+        // is the register (by its number) alive after the instruction
+        bool isLiveAfter(std::size_t, std::size_t);
+
+        std::size_t numberOfRegisters();
+
+        // analysed register file
+        bool floating = false;
+
+        // number of the argument registers of the analysed file. They are the same in every function
+        std::size_t argument_registers = 0;
+
+        // register number -> dense number
+        std::map<std::size_t, std::size_t> to_dense;
+
+        // registers, which instruction reads
+        std::vector<std::vector<std::size_t>> uses;
+
+        // register, which instruction writes. -1 if nothing
+        std::vector<long long> defs;
+
+        // registers, which are destroyed by the instruction besides its def (argument registers by the call)
+        std::vector<std::vector<std::size_t>> clobbers;
+
+        // register, which is copied by the instruction (MOV between two registers). -1 if it is not a copy
+        std::vector<long long> move_source;
+
+        // number of the loops around the instruction
+        std::vector<std::size_t> loop_depth;
+
+        std::vector<std::vector<std::size_t>> successors;
+
+        // is register alive before/after the instruction
+        std::vector<std::vector<bool>> live_in, live_out;
+    };
+}
+
+#endif //COMPILER_LIVENESS_H
@@ -2,96 +2,119 @@
 #define COMPILER_OPERAND_H
 
 #include <string>
-#include <memory>
+#include <cstdint>
+#include <climits>
+
+#include "Writer.h"
 
 namespace T86 {
 
     /**
-     * Operand of the target code
+     * Operand of the target code. Small value kept right inside the instruction: an immediate, a register
+     * (with an offset) or the memory addressed by a register with an offset (or by the absolute address).
+     * Classes below only build it
      */
     class Operand {
     public:
-        virtual std::string toString() = 0;
+        enum Kind : std::uint8_t {
+            NONE,
+            INT,
+            DOUBLE,
+            REGISTER,
+            FREGISTER,
+            MEMORY
+        };
 
-        virtual std::unique_ptr<Operand> clone() const = 0;
+        Operand() = default;
 
-    private:
-    };
+        Kind getKind() const;
 
-    class IntImmediate : public Operand {
-    public:
-        IntImmediate(long long = 0);
+        bool isIntImmediate() const;
 
-        void addValue(long long);
-
-        std::string toString() override;
+        bool isDoubleImmediate() const;
 
-        std::unique_ptr<Operand> clone() const override;
+        bool isRegister() const;
 
-    private:
-        long long value;
+        bool isFRegister() const;
 
-    };
+        bool isMemory() const;
 
-    class DoubleImmediate : public Operand {
-    public:
-        DoubleImmediate(double = 0);
+        // value of the integer immediate
+        long long getValue() const;
 
-        std::string toString() override;
+        void addValue(long long);
 
-        std::unique_ptr<Operand> clone() const override;
+        // value of the double immediate
+        double getReal() const;
 
-    private:
-        double value;
+        // number of the register, or of the register, which holds the address of the memory
+        std::size_t getNumber() const;
 
-    };
+        void setNumber(std::size_t);
 
-    class Register : public Operand {
-    public:
-        Register(std::size_t = 0, long long = 0);
+        // offset of the register, or of the address of the memory
+        long long getOffset() const;
 
-        enum SecialRegisters {
-            SP = ULLONG_MAX - 1,
-            BP = ULLONG_MAX - 2,
-            IP = ULLONG_MAX - 3,
-        };
+        // is it one of BP, SP or IP (or the memory addressed by them, or by the absolute address)
+        bool isSpecial() const;
 
-        std::string toString() override;
+        // is it the memory at the absolute address (kept as the offset)
+        bool isAbsolute() const;
 
-        std::unique_ptr<Operand> clone() const override;
+        // register with the offset (or the immediate), which gives the address of the memory
+        Operand getAddr() const;
 
-    private:
-        std::size_t register_number;
+        bool operator==(const Operand &) const;
 
-        long long offset = 0;
-    };
+        std::string toString() const;
 
-    class FRegister : public Operand {
-    public:
-        FRegister(std::size_t = 0);
+        // same text as toString, formatted right into the output
+        void print(Writer &) const;
 
-        std::string toString() override;
+    protected:
+        Kind kind = NONE;
 
-        std::unique_ptr<Operand> clone() const override;
-
-    private:
-        std::size_t reg_number;
+        std::uint32_t number = 0;
 
+        // immediate or the offset of the register
+        union {
+            long long value = 0;
+            double real;
+        };
     };
 
-    class Memory : public Operand {
+    class IntImmediate : public Operand {
     public:
-        Memory(std::unique_ptr<Operand> &&);
+        IntImmediate(long long = 0);
+    };
 
-        Memory(const Memory&);
+    class DoubleImmediate : public Operand {
+    public:
+        DoubleImmediate(double = 0);
+    };
 
-        std::string toString() override;
+    class Register : public Operand {
+    public:
+        Register(std::size_t = 0, long long = 0);
 
-        std::unique_ptr<Operand> clone() const override;
+        enum SecialRegisters : std::uint32_t {
+            SP = UINT32_MAX - 1,
+            BP = UINT32_MAX - 2,
+            IP = UINT32_MAX - 3,
+            // memory is addressed without a register
+            NO_REGISTER = UINT32_MAX
+        };
+    };
 
-    private:
-        std::unique_ptr<Operand> addr;
+    class FRegister : public Operand {
+    public:
+        FRegister(std::size_t = 0);
+    };
 
+    class Memory : public Operand {
+    public:
+        // address is in the register (with the offset), or it is the immediate
+        Memory(const Operand &);
     };
 }
 
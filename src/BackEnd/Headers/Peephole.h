@@ -0,0 +1,120 @@
+#ifndef COMPILER_PEEPHOLE_H
+#define COMPILER_PEEPHOLE_H
+
+#include <vector>
+#include <set>
+#include <array>
+#include <string>
+#include <functional>
+
+#include "T86Inst.h"
+#include "Liveness.h"
+
+namespace T86 {
+
+    /**
+     * Peephole optimiser over the resolved target code. Rules are given by the table: a window of the
+     * instruction patterns with constraints on their operands, and the replacement of the whole window.
+     * The window slides over every function, until none of the rules fires
+     */
+    class Peephole {
+    public:
+        Peephole();
+
+        void run(T86Program &);
+
+        // prints how many times each rule has fired
+        void printReport(std::ostream &);
+
+        // adds the counts of the other optimiser
+        void merge(const Peephole &);
+
+    private:
+        // what can be matched by the operand of the pattern
+        enum OperandKind {
+            NONE,       // operand is absent
+            ANY,
+            REG,        // general purpose register
+            VALUE,      // general purpose register or an integer immediate
+            IMM,        // integer immediate
+            MEM,
+            STACK       // SP
+        };
+
+        /**
+         * Operand of the pattern. Matched operand is bound to the variable. If the variable is already bound,
+         * operand has to be the same
+         */
+        struct OperandPattern {
+            OperandKind kind = NONE;
+
+            // -1 if operand is not bound
+            int var = -1;
+        };
+
+        struct InstructionPattern {
+            std::set<Instruction::Opcode> opcodes;
+
+            OperandPattern first, second;
+        };
+
+        enum ConstraintKind {
+            DEAD,           // register is not alive after the window
+            DIFFERENT,      // operands are not the same
+            NOT_BASED_ON,   // memory operand does not use the register
+            ZERO,           // immediate is 0
+            NEXT            // immediate is the address of the instruction after the window
+        };
+
+        struct Constraint {
+            ConstraintKind kind;
+
+            int var, other = -1;
+        };
+
+        /**
+         * Matched window
+         */
+        struct Match {
+            std::vector<Instruction *> window;
+
+            std::array<Operand *, 4> vars{};
+
+            // bound operand as a new one
+            Operand take(int);
+
+            long long value(int);
+        };
+
+        struct Rule {
+            std::string name;
+
+            std::vector<InstructionPattern> pattern;
+
+            std::vector<Constraint> constraints;
+
+            // branch targets in the replacement are addresses of the old code
+            std::function<std::vector<Instruction>(Match &)> replace;
+
+            std::size_t fired = 0;
+        };
+
+        // one pass over the whole program. Returns true, if something was replaced
+        bool sweep(T86Program &);
+
+        bool match(Rule &, std::vector<Instruction> &, std::size_t, Match &);
+
+        bool matchOperand(const OperandPattern &, Operand *, Match &);
+
+        bool satisfies(const Constraint &, std::size_t, std::size_t, Match &);
+
+        std::vector<Rule> rules;
+
+        // liveness of the current function and its first instruction. nullptr outside of the functions
+        Liveness *liveness = nullptr;
+
+        std::size_t function_begin = 0;
+    };
+}
+
+#endif //COMPILER_PEEPHOLE_H
@@ -0,0 +1,242 @@
+#ifndef COMPILER_REGALLOC_H
+#define COMPILER_REGALLOC_H
+
+#include <vector>
+#include <map>
+#include <set>
+
+#include "T86Inst.h"
+#include "Liveness.h"
+
+namespace T86 {
+
+    /**
+     * Maps the unbounded virtual registers of each function onto a fixed number of the physical ones.
+     * General purpose and float registers are allocated separately, one file after another.
+     * Values, which do not fit, are spilled into the frame of the function (relative to BP),
+     * constants are rematerialised instead of spilling. Registers, which function writes, are saved
+     * by the function itself (callee-saved), except the argument registers of the calling convention.
+     * Those keep their numbers and no value, which crosses their use, is placed into them
+     */
+    class RegisterAllocator {
+    public:
+        // number of the general purpose and of the float registers
+        RegisterAllocator(std::size_t, std::size_t);
+
+        virtual ~RegisterAllocator() = default;
+
+        // allocation of each function is a span of the trace, if the profiler is given
+        void run(T86Program &, Profiler * = nullptr);
+
+        // prints the spill counts and instruction counts of each function
+        void printReport(std::ostream &);
+
+        // adds the statistics of the allocator, which has run over the code after this one
+        void merge(const RegisterAllocator &);
+
+    protected:
+        /**
+         * Live range of the single virtual register over the linear code of the function
+         */
+        struct Interval {
+            // dense number of the virtual register
+            std::size_t reg = 0;
+
+            // first and last position (inside the function), where register is alive
+            std::size_t start = 0, end = 0;
+
+            // interval starts by the definition, so register, which dies at the start, can be reused
+            bool starts_with_def = false;
+
+            // register is defined only once by a constant, so it does not need the place to spill
+            bool remat = false;
+
+            long long constant = 0;
+
+            // register, from which this one is copied by MOV. Uses to coalesce the move
+            long long hint = -1;
+
+            // physical register of the calling convention. -1 for the virtual ones
+            long long fixed = -1;
+
+            // registers of the calling convention, which are written, while this one is alive (or the other way)
+            std::set<std::size_t> forbidden;
+        };
+
+        // assign the physical registers [0, number) to the intervals, which are not fixed.
+        // returns virtual (dense) -> physical register. Not mapped registers are spilled
+        virtual std::map<std::size_t, std::size_t> assign(std::vector<Interval> &, std::size_t) = 0;
+
+        std::size_t number_of_registers;
+
+        std::size_t number_of_float_registers;
+
+        // is the float register file being allocated
+        bool floating = false;
+
+        // liveness of the virtual registers in the current function
+        Liveness liveness;
+
+    private:
+        /**
+         * Result of the allocation of the single function
+         */
+        struct Statistics {
+            std::string name;
+
+            std::size_t instructions = 0;
+
+            std::size_t spilled = 0;
+
+            std::size_t rematerialised = 0;
+
+            std::size_t coalesced = 0;
+
+            bool floating = false;
+        };
+
+        std::vector<Statistics> statistics;
+
+        Profiler *profiler = nullptr;
+
+        // allocate the current register file in the whole program
+        void allocateFile(T86Program &);
+
+        // analyse the function (by its order) and build the live intervals
+        std::vector<Interval> analyse(T86Program &, std::size_t);
+
+        // returns the number of the words, which spilled registers add to the frame
+        long long allocateFunction(T86Program &, std::size_t, std::vector<Instruction> &, std::vector<std::size_t> &);
+
+        // assignment of the current function with the fixed registers
+        void assignAll(std::size_t);
+
+        // replace the virtual register in the first (or the second) operand by the physical one.
+        // spilled ones are loaded before and stored after the instruction
+        void rewriteRegister(Instruction &, bool, std::vector<Instruction> &, std::vector<Instruction> &);
+
+        // register of the current file
+        Operand makeRegister(std::size_t);
+
+        std::vector<Interval> intervals;
+
+        std::map<std::size_t, std::size_t> assignment;
+
+        // place on the stack by the spilled register
+        std::map<std::size_t, long long> spill_place;
+
+        // registers for the spilled values. Empty, if nothing is spilled
+        std::vector<std::size_t> scratch;
+
+        // which spilled register is in which scratch one, while rewriting the instruction
+        std::map<std::size_t, std::size_t> in_scratch;
+
+        // current position while rewriting
+        std::size_t position = 0;
+    };
+
+    /**
+     * Graph colouring with the iterated register coalescing (George & Appel) and optimistic
+     * colouring (Briggs). Candidates to spill are chosen by the cost of their uses weighted by
+     * the loop depth, divided by the degree in the interference graph
+     */
+    class GraphColoringAllocator : public RegisterAllocator {
+    public:
+        using RegisterAllocator::RegisterAllocator;
+
+    protected:
+        std::map<std::size_t, std::size_t> assign(std::vector<Interval> &, std::size_t) override;
+
+    private:
+        enum NodeState {
+            INITIAL, SIMPLIFY, FREEZE, SPILL, COALESCED, SELECT, PRECOLORED
+        };
+
+        enum MoveState {
+            WORKLIST, ACTIVE, DONE
+        };
+
+        void build(std::vector<Interval> &);
+
+        void addEdge(std::size_t, std::size_t);
+
+        void makeWorklist();
+
+        // neighbours, which are still in the graph
+        std::vector<std::size_t> adjacent(std::size_t);
+
+        // moves of the node, which still might be coalesced
+        std::vector<std::size_t> nodeMoves(std::size_t);
+
+        bool moveRelated(std::size_t);
+
+        void simplify();
+
+        void decrementDegree(std::size_t);
+
+        void enableMoves(std::size_t);
+
+        void coalesce();
+
+        void addWorkList(std::size_t);
+
+        // Briggs test -- combined node has less than K neighbours of significant degree
+        bool conservative(std::size_t, std::size_t);
+
+        std::size_t getAlias(std::size_t);
+
+        void combine(std::size_t, std::size_t);
+
+        void freeze();
+
+        void freezeMoves(std::size_t);
+
+        void selectSpill();
+
+        std::map<std::size_t, std::size_t> assignColors();
+
+        std::size_t colors = 0;
+
+        std::set<std::pair<std::size_t, std::size_t>> adj_set;
+
+        std::vector<std::set<std::size_t>> adj_list;
+
+        std::vector<std::size_t> degree;
+
+        std::vector<std::size_t> alias;
+
+        std::vector<NodeState> node_state;
+
+        std::vector<double> spill_cost;
+
+        // colours, which node can not take, and the one it is copied from/to. -1 if there is no such
+        std::vector<std::set<std::size_t>> forbidden;
+
+        std::vector<long long> preference;
+
+        // copies (to, from) and their states
+        std::vector<std::pair<std::size_t, std::size_t>> moves;
+
+        std::vector<MoveState> move_state;
+
+        std::vector<std::vector<std::size_t>> move_list;
+
+        std::set<std::size_t> simplify_worklist, freeze_worklist, spill_worklist, worklist_moves;
+
+        std::vector<std::size_t> select_stack;
+    };
+
+    /**
+     * Linear scan over live intervals (Poletto & Sarkar). When there is no free register,
+     * spills the rematerialisable interval, or the one, which ends the last
+     */
+    class LinearScanAllocator : public RegisterAllocator {
+    public:
+        using RegisterAllocator::RegisterAllocator;
+
+    protected:
+        std::map<std::size_t, std::size_t> assign(std::vector<Interval> &, std::size_t) override;
+    };
+}
+
+#endif //COMPILER_REGALLOC_H
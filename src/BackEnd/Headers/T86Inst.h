@@ -1,16 +1,18 @@
 #ifndef COMPILER_T86INST_H
 #define COMPILER_T86INST_H
 
-#include <variant>
 #include <memory>
 #include <vector>
 #include <map>
 #include <set>
 #include <iostream>
+#include <string_view>
 
 //#include "magic_enum.hpp"
 
 #include "Operands.h"
+#include "Writer.h"
+#include "Profiler.h"
 
 namespace T86 {
 
@@ -72,104 +74,226 @@ namespace T86 {
             NOP
         };
 
-        inline static const std::map<Opcode, std::string> opcode_to_str = {
-                {MOV,     "MOV"},
-                {LEA,     "LEA"},
-                {ADD,     "ADD"},
-                {SUB,     "SUB"},
-                {INC,     "INC"},
-                {DEC,     "DEC"},
-                {NEG,     "NEG"},
-                {MUL,     "MUL"},
-                {DIV,     "DIV"},
-                {IMUL,    "IMUL"},
-                {IDIV,    "IDIV"},
-                {FADD,    "FADD"},
-                {FSUB,    "FSUB"},
-                {FMUL,    "FMUL"},
-                {FDIV,    "FDIV"},
-                {AND,     "AND"},
-                {OR,      "OR"},
-                {XOR,     "XOR"},
-                {LSH,     "LSH"},
-                {RSH,     "RSH"},
-                {CMP,     "CMP"},
-                {FCMP,    "FCMP"},
-                {JMP,     "JMP"},
-                {LOOP,    "LOOP"},
-                {JZ,      "JZ"},
-                {JNZ,     "JNZ"},
-                {JE,      "JE"},
-                {JNE,     "JNE"},
-                {JG,      "JG"},
-                {JGE,     "JGE"},
-                {JL,      "JL"},
-                {JLE,     "JLE"},
-                {JA,      "JA"},
-                {JAE,     "JAE"},
-                {JB,      "JB"},
-                {JBE,     "JBE"},
-                {JO,      "JO"},
-                {JNO,     "JNO"},
-                {JS,      "JS"},
-                {JNS,     "JNS"},
-                {CALL,    "CALL"},
-                {RET,     "RET"},
-                {PUSH,    "PUSH"},
-                {FPUSH,   "FPUSH"},
-                {POP,     "POP"},
-                {FPOP,    "FPOP"},
-                {PUTCHAR, "PUTCHAR"},
-                {PUTNUM,  "PUTNUM"},
-                {GETCHAR, "GETCHAR"},
-                {EXT,     "EXT"},
-                {NRW,     "NRW"},
-                {HALT,    "HALT"},
-                {NOP,     "NOP"}
+        // names of the opcodes, in the order of the enum
+        static constexpr std::string_view opcode_to_str[] = {
+                "MOV",
+                "LEA",
+                "ADD",
+                "SUB",
+                "INC",
+                "DEC",
+                "NEG",
+                "MUL",
+                "DIV",
+                "IMUL",
+                "IDIV",
+                "FADD",
+                "FSUB",
+                "FMUL",
+                "FDIV",
+                "AND",
+                "OR",
+                "XOR",
+                "LSH",
+                "RSH",
+                "CMP",
+                "FCMP",
+                "JMP",
+                "LOOP",
+                "JZ",
+                "JNZ",
+                "JE",
+                "JNE",
+                "JG",
+                "JGE",
+                "JL",
+                "JLE",
+                "JA",
+                "JAE",
+                "JB",
+                "JBE",
+                "JO",
+                "JNO",
+                "JS",
+                "JNS",
+                "CALL",
+                "RET",
+                "PUSH",
+                "FPUSH",
+                "POP",
+                "FPOP",
+                "PUTCHAR",
+                "PUTNUM",
+                "GETCHAR",
+                "EXT",
+                "NRW",
+                "HALT",
+                "NOP"
         };
 
-        Instruction(Opcode, std::unique_ptr<Operand> && = nullptr, std::unique_ptr<Operand> && = nullptr);
+        Instruction(Opcode, const Operand & = Operand(), const Operand & = Operand());
 
-        void addOperand(std::unique_ptr<Operand> &&);
+        void addOperand(const Operand &);
 
         Opcode getOpcode();
 
-        void print(std::ostream &);
+        // nullptr, if the instruction does not have the operand
+        Operand *getFirst();
+
+        Operand *getSecond();
+
+        void setFirst(const Operand &);
+
+        void setSecond(const Operand &);
+
+        // does the instruction transfer control to the address in its first operand (jumps and calls)
+        static bool isBranch(Opcode);
+
+        // does the instruction end the control flow, so the next instruction is not its successor
+        static bool isTerminator(Opcode);
+
+        // does the instruction read the value of its first operand
+        static bool readsFirst(Opcode);
+
+        // does the instruction write the result into its first operand
+        static bool writesFirst(Opcode);
+
+        // can the second operand of the instruction be an immediate
+        static bool acceptsImmediate(Opcode);
+
+        // is the instruction a jump by the condition
+        static bool isConditional(Opcode);
+
+        // conditional jump with the opposite condition
+        static Opcode invertCondition(Opcode);
+
+        void print(Writer &);
 
     private:
         Opcode op;
 
         // sometimes 0 (HELT, RET), sometimes 1 (CALL, PUSH)
-        std::unique_ptr<Operand> first, second;
+        Operand first, second;
 
     };
 
 
+    /**
+     * Register calling convention. The first scalar arguments of each register file are passed in
+     * R0.. (F0..), the scalar result is returned in R0 (F0). The rest of the arguments is pushed to the
+     * stack. Registers of the convention are saved by the caller, all others by the callee.
+     * With no registers everything goes through the stack and the result has its own slot there
+     */
+    struct CallingConvention {
+        // number of the argument registers of the general purpose and of the float file
+        std::size_t registers = 0, float_registers = 0;
+
+        // registers under this number are reserved by the convention in every function
+        std::size_t reserved();
+    };
+
+    /**
+     * What passes over the target code need to know about a single function
+     */
+    struct FunctionInfo {
+        std::string name;
+
+        // index of the first instruction of the function
+        std::size_t begin = 0;
+
+        // words allocated under the BP for the variables (and for the spilled registers)
+        long long frame_size = 0;
+
+        // prologue allocates the frame by SUB SP right after MOV BP,SP. Every epilogue frees it by ADD SP
+        // right before POP BP
+        bool frame_alloc = false;
+
+        // objects of the frame (variables and spilled registers): offset of the first word from BP and the size.
+        // Words of the object go down from the first one
+        std::vector<std::pair<long long, long long>> frame_objects;
+
+        // arguments passed in R0.. and in F0.. by the register calling convention
+        std::size_t register_arguments = 0, float_register_arguments = 0;
+
+        // result is returned in R0 (or in F0) by the register calling convention
+        bool register_result = false, float_register_result = false;
+    };
+
     class T86Program {
     public:
         Instruction *emplaceInstruction(Instruction &&);
 
-        void print(std::ostream &);
+        void print(Writer &);
 
         std::size_t getNumberOfInstructions();
 
+        std::vector<Instruction> &getInstructions();
+
+        void addFunction(std::string);
+
+        std::vector<FunctionInfo> &getFunctions();
+
+        // one past the last instruction of the function by its order
+        std::size_t functionEnd(std::size_t);
+
+        // replace the code by the new one, which was build from the old one.
+        // new_place[i] is the new index of the old i-th instruction (or the first instruction inserted
+        // in its place). Targets of all jumps and calls and starts of the functions are moved accordingly
+        void relocate(std::vector<Instruction> &&, const std::vector<std::size_t> &);
+
+        // SUB SP of the prologue of the function by its order. nullptr, if function does not allocate anything
+        Instruction *frameAllocation(std::size_t);
+
+        // sets the new frame size of the function by its order and fulfills all places with it
+        void setFrameSize(std::size_t, long long);
+
+        CallingConvention &getCallingConvention();
+
+        // function, which starts at the address (the external one for the negative address). nullptr, if there
+        // is none
+        FunctionInfo *functionAt(long long);
+
+        // places the words at the end of the .data segment. Returns the address of the first one
+        long long addData(const std::vector<Operand> &);
+
+        const std::vector<Operand> &getData();
+
+        // function called by the program, which is not in it. CALL -1-i calls the i-th one. Until more is
+        // known, it may take all the argument registers
+        long long addExternal(const std::string &);
+
+        std::vector<FunctionInfo> &getExternals();
+
+        // places the code of the other program after this one. Its calls stay external
+        void append(T86Program &&);
+
+        // calls of the external functions, which are in the program now, get their address
+        void linkExternals();
+
     private:
         // .text segment
         std::vector<Instruction> program;
 
-        // also need to add .data segment
+        // .data segment, it starts at the address 0
+        std::vector<Operand> data;
+
+        std::vector<FunctionInfo> externals;
+
+        std::vector<FunctionInfo> functions;
+
+        CallingConvention convention;
     };
 
     class MemorySpace {
     public:
         void addOperand(unsigned long long);
 
-        void addOperand(unsigned long long, std::unique_ptr<T86::Memory>);
+        void addOperand(unsigned long long, const Memory &);
 
-        std::unique_ptr<Operand> getOperand(unsigned long long);
+        Operand getOperand(unsigned long long);
 
     private:
-        std::map<unsigned long long, std::unique_ptr<Operand>> register_space;
+        std::map<unsigned long long, Operand> register_space;
 
     };
 
@@ -178,6 +302,9 @@ namespace T86 {
      */
     class Context {
     public:
+        // lowering of each function is a span of the trace, if it is set
+        Profiler *profiler = nullptr;
+
         long long offset_of_function = 0;
 
         long long allocated_space_for_variables = 0;
@@ -189,44 +316,70 @@ namespace T86 {
 
         long long getCurrentPlaceOnStack(long long);
 
-        std::unique_ptr<Operand> getOperand(unsigned long long);
+        Operand getOperand(unsigned long long);
 
         void addInstruction(Instruction &&);
 
-        void print(std::ostream &);
+        void print(Writer &);
 
         std::size_t getNumberOfInstructions();
 
-        // add place, where function is called
-        void addFunctionCall(std::string, IntImmediate *);
+        // function is called by the next instruction
+        void addFunctionCall(std::string);
 
         // add place where functions starts
         void addFunctionPlace(std::string);
 
-        // add place where label is called
-        void addJumpToLabel(long long, IntImmediate *);
+        // next instruction jumps to the label
+        void addJumpToLabel(long long);
 
         // add place where label starts
         void addLabelPlace(long long);
 
-        // fulfill all function and label callers with values
+        // add function, which returns a value through the stack
+        void addReturningFunction(std::string);
+
+        bool doesFunctionReturn(std::string);
+
+        // set the size of the frame of the current function. If it is not empty, the next instruction
+        // allocates it
+        void addFrameAllocation(long long);
+
+        // add object to the frame of the current function by its place and size
+        void addFrameObject(long long, long long);
+
+        // places the words into the .data segment. Returns the address of the first one
+        long long addData(const std::vector<Operand> &);
+
+        T86Program &getProgram();
+
+        FunctionInfo &currentFunction();
+
+        // fulfill all function and label callers with values, calls of the functions, which are not in
+        // the program, with the externals. Jumps to the next instruction are dropped
         void finishCallsAndJmps();
         
     private:
+        // removes JMP to the next instruction and Jcc over the JMP, which is replaced by the opposite Jcc
+        void removeFallthroughJumps();
+
         MemorySpace mem_allocator;
 
         T86Program program;
 
-        std::map<long long, std::unique_ptr<Operand>> instructionToOperand;
+        std::map<long long, Operand> instructionToOperand;
 
-        std::map<std::string, std::vector<IntImmediate *>> notFinishedCalls;
+        // indexes of the calls and the jumps, whose targets are not known yet
+        std::map<std::string, std::vector<std::size_t>> notFinishedCalls;
 
         std::set<std::pair<std::string, size_t>> placeForCall;
 
-        std::map<long long, std::vector<IntImmediate *>> notFinishedJumps;
+        std::map<long long, std::vector<std::size_t>> notFinishedJumps;
 
         std::set<std::pair<long long, size_t>> placeForJumps;
 
+        std::set<std::string> returningFunctions;
+
         long long current_place_on_stack = 0;
 
     };
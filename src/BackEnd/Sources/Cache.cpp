@@ -0,0 +1,251 @@
+#include "Cache.h"
+
+#include <bit>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+// changes, whenever the layout of the file or the generated code changes
+static const std::string format = "T86 function cache 1";
+
+// entries in the memory, after which it is emptied
+static const std::size_t memoryLimit = 1 << 16;
+
+template<typename T>
+static void put(std::ostream &out, T value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+static void put(std::ostream &out, const std::string &text) {
+    put(out, (std::uint64_t) text.size());
+    out.write(text.data(), (std::streamsize) text.size());
+}
+
+template<typename T>
+static T get(std::istream &in) {
+    T value{};
+    if (!in.read(reinterpret_cast<char *>(&value), sizeof(value)))
+        throw std::invalid_argument("ERROR. Entry of the cache is broken.");
+    return value;
+}
+
+static std::string getString(std::istream &in) {
+    auto size = get<std::uint64_t>(in);
+    if (size > (1 << 20))
+        throw std::invalid_argument("ERROR. Entry of the cache is broken.");
+    std::string res(size, '\0');
+    if (!in.read(res.data(), (std::streamsize) size))
+        throw std::invalid_argument("ERROR. Entry of the cache is broken.");
+    return res;
+}
+
+static void putOperand(std::ostream &out, const T86::Operand *operand) {
+    if (!operand) {
+        put(out, (std::uint8_t) T86::Operand::NONE);
+        return;
+    }
+    put(out, (std::uint8_t) operand->getKind());
+    put(out, (std::uint64_t) operand->getNumber());
+    if (operand->isIntImmediate())
+        put(out, operand->getValue());
+    else if (operand->isDoubleImmediate())
+        put(out, std::bit_cast<long long>(operand->getReal()));
+    else
+        put(out, operand->getOffset());
+}
+
+static T86::Operand getOperand(std::istream &in) {
+    auto kind = get<std::uint8_t>(in);
+    if (kind == T86::Operand::NONE)
+        return {};
+    auto number = get<std::uint64_t>(in);
+    auto value = get<long long>(in);
+    switch (kind) {
+        case T86::Operand::INT:
+            return T86::IntImmediate(value);
+        case T86::Operand::DOUBLE:
+            return T86::DoubleImmediate(std::bit_cast<double>(value));
+        case T86::Operand::REGISTER:
+            return T86::Register(number, value);
+        case T86::Operand::FREGISTER:
+            return T86::FRegister(number);
+        case T86::Operand::MEMORY:
+            if (number == T86::Register::NO_REGISTER)
+                return T86::Memory(T86::IntImmediate(value));
+            return T86::Memory(T86::Register(number, value));
+        default:
+            throw std::invalid_argument("ERROR. Entry of the cache is broken.");
+    }
+}
+
+T86::FunctionCache::FunctionCache(const std::string &new_directory, Memory *new_memory)
+        : directory(new_directory), memory(new_memory) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+}
+
+bool T86::FunctionCache::load(const std::string &key, Entry &entry) {
+    std::string contents;
+    if (!readFile(path(key), contents)) {
+        ++misses;
+        return false;
+    }
+
+    std::istringstream in(contents);
+    try {
+        if (getString(in) != format || getString(in) != key)
+            throw std::invalid_argument("ERROR. Entry of the cache is broken.");
+        read(in, entry);
+    } catch (std::invalid_argument &) {
+        entry = Entry();
+        ++misses;
+        return false;
+    }
+    ++hits;
+    return true;
+}
+
+void T86::FunctionCache::store(const std::string &key, Entry &entry) {
+    std::ostringstream contents;
+    put(contents, format);
+    put(contents, key);
+    save(contents, entry);
+
+    // the other compiler may read the entry at the same time, so it appears at once
+    auto temporary = path(key) + "." + std::to_string(getpid()) + "."
+                     + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return;
+        out << contents.view();
+        if (!out)
+            return;
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path(key), error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        return;
+    }
+    ++stored;
+    remember(path(key), std::move(contents).str());
+}
+
+void T86::FunctionCache::printReport(std::ostream &oss) {
+    oss << "cache hits misses stored" << std::endl;
+    oss << "functions " << hits << ' ' << misses << ' ' << stored << std::endl;
+}
+
+bool T86::FunctionCache::readFile(const std::string &file, std::string &contents) {
+    if (memory) {
+        std::lock_guard guard(memory->lock);
+        if (auto found = memory->files.find(file); found != memory->files.end()) {
+            contents = found->second;
+            return true;
+        }
+    }
+
+    std::ifstream in(file, std::ios::binary);
+    if (!in)
+        return false;
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    contents = std::move(buffer).str();
+    remember(file, contents);
+    return true;
+}
+
+void T86::FunctionCache::remember(const std::string &file, std::string contents) {
+    if (!memory)
+        return;
+    std::lock_guard guard(memory->lock);
+    if (memory->files.size() >= memoryLimit)
+        memory->files.clear();
+    memory->files[file] = std::move(contents);
+}
+
+std::string T86::FunctionCache::path(const std::string &key) {
+    return directory + "/" + key + ".fn";
+}
+
+void T86::FunctionCache::save(std::ostream &out, Entry &entry) {
+    put(out, entry.values);
+
+    put(out, (std::uint64_t) entry.read_only.size());
+    for (auto i: entry.read_only)
+        put(out, (std::uint8_t) i);
+
+    auto &program = entry.code;
+    put(out, (std::uint64_t) program.getExternals().size());
+    for (auto &i: program.getExternals())
+        put(out, i.name);
+
+    put(out, (std::uint64_t) program.getFunctions().size());
+    for (auto &i: program.getFunctions()) {
+        put(out, i.name);
+        put(out, (std::uint64_t) i.begin);
+        put(out, i.frame_size);
+        put(out, (std::uint8_t) i.frame_alloc);
+        put(out, (std::uint64_t) i.frame_objects.size());
+        for (auto &[place, size]: i.frame_objects) {
+            put(out, place);
+            put(out, size);
+        }
+        put(out, (std::uint64_t) i.register_arguments);
+        put(out, (std::uint64_t) i.float_register_arguments);
+        put(out, (std::uint8_t) i.register_result);
+        put(out, (std::uint8_t) i.float_register_result);
+    }
+
+    put(out, (std::uint64_t) program.getInstructions().size());
+    for (auto &i: program.getInstructions()) {
+        put(out, (std::uint8_t) i.getOpcode());
+        putOperand(out, i.getFirst());
+        putOperand(out, i.getSecond());
+    }
+}
+
+void T86::FunctionCache::read(std::istream &in, Entry &entry) {
+    entry.values = get<long long>(in);
+
+    entry.read_only.resize(get<std::uint64_t>(in));
+    for (std::size_t i = 0; i < entry.read_only.size(); ++i)
+        entry.read_only[i] = get<std::uint8_t>(in);
+
+    auto &program = entry.code;
+    auto externals = get<std::uint64_t>(in);
+    for (std::uint64_t i = 0; i < externals; ++i)
+        program.addExternal(getString(in));
+
+    auto functions = get<std::uint64_t>(in);
+    for (std::uint64_t k = 0; k < functions; ++k) {
+        auto &i = program.getFunctions().emplace_back();
+        i.name = getString(in);
+        i.begin = get<std::uint64_t>(in);
+        i.frame_size = get<long long>(in);
+        i.frame_alloc = get<std::uint8_t>(in);
+        auto objects = get<std::uint64_t>(in);
+        for (std::uint64_t o = 0; o < objects; ++o) {
+            auto place = get<long long>(in);
+            i.frame_objects.emplace_back(place, get<long long>(in));
+        }
+        i.register_arguments = get<std::uint64_t>(in);
+        i.float_register_arguments = get<std::uint64_t>(in);
+        i.register_result = get<std::uint8_t>(in);
+        i.float_register_result = get<std::uint8_t>(in);
+    }
+
+    auto instructions = get<std::uint64_t>(in);
+    for (std::uint64_t k = 0; k < instructions; ++k) {
+        auto opcode = get<std::uint8_t>(in);
+        if (opcode > Instruction::NOP)
+            throw std::invalid_argument("ERROR. Entry of the cache is broken.");
+        auto first = getOperand(in);
+        auto second = getOperand(in);
+        program.emplaceInstruction(Instruction((Instruction::Opcode) opcode, first, second));
+    }
+}
@@ -0,0 +1,375 @@
+#include "Frame.h"
+#include "Liveness.h"
+
+#include <climits>
+#include <algorithm>
+
+namespace {
+    using T86::Instruction;
+    using T86::Register;
+
+    bool isRegister(T86::Operand *operand, std::size_t number) {
+        return operand && operand->isRegister() && operand->getNumber() == number && !operand->getOffset();
+    }
+
+    bool isStackPointer(T86::Operand *operand) {
+        return operand && (operand->isRegister() || operand->isMemory()) && operand->getNumber() == Register::SP;
+    }
+}
+
+void T86::FrameOptimiser::promoteSlots(T86Program &program) {
+    for (std::size_t i = 0; i < program.getFunctions().size(); ++i)
+        promoteFunction(program, i);
+}
+
+void T86::FrameOptimiser::promoteFunction(T86Program &program, std::size_t function) {
+    auto &code = program.getInstructions();
+    auto begin = program.getFunctions()[function].begin, end = program.functionEnd(function);
+
+    std::map<long long, Slot> slots;
+
+    // LEA of [BP + k] gives the address of k and of everything under it (members of the structure)
+    long long escaped_below = LLONG_MIN;
+
+    // first free virtual registers
+    std::size_t next_register = 0, next_float_register = 0;
+
+    for (auto k = begin; k < end; ++k) {
+        auto &inst = code[k];
+        auto op = inst.getOpcode();
+        std::array<Operand *, 2> operands = {inst.getFirst(), inst.getSecond()};
+
+        for (std::size_t j = 0; j < 2; ++j) {
+            auto operand = operands[j];
+            if (!operand)
+                continue;
+
+            if (operand->isFRegister())
+                next_float_register = std::max(next_float_register, operand->getNumber() + 1);
+
+            if ((operand->isRegister() || operand->isMemory()) && !operand->isSpecial())
+                next_register = std::max(next_register, operand->getNumber() + 1);
+
+            // BP as the value (besides the prologue and the epilogue) -- nothing is known about the frame
+            if (isRegister(operand, Register::BP) && op != Instruction::PUSH && op != Instruction::POP &&
+                !(op == Instruction::MOV && j == 0 && isRegister(operands[1], Register::SP)))
+                return;
+
+            long long offset;
+            if (!frameOffset(operand, offset))
+                continue;
+            if (op == Instruction::LEA) {
+                escaped_below = std::max(escaped_below, offset);
+                continue;
+            }
+            // arguments on the stack stay there
+            if (offset >= 0)
+                continue;
+
+            auto &slot = slots[offset];
+            auto other = operands[1 - j];
+            if (op != Instruction::MOV || other->isMemory())
+                slot.escaped = true;
+            else if (other->isFRegister() || other->isDoubleImmediate())
+                slot.floating = true;
+            else if (other->isRegister())
+                slot.general = true;
+        }
+    }
+
+    std::map<long long, Operand> promoted;
+    for (auto &[offset, slot]: slots) {
+        if (slot.escaped || offset <= escaped_below || (slot.general && slot.floating))
+            continue;
+        if (slot.floating)
+            promoted[offset] = FRegister(next_float_register++);
+        else
+            promoted[offset] = Register(next_register++);
+    }
+
+    for (auto k = begin; k < end; ++k) {
+        auto &inst = code[k];
+        long long offset;
+        if (frameOffset(inst.getFirst(), offset) && promoted.count(offset)) {
+            inst.setFirst(promoted[offset]);
+            // float register can not be filled by the integer
+            auto constant = inst.getSecond();
+            if (constant && constant->isIntImmediate() && inst.getFirst()->isFRegister())
+                inst.setSecond(DoubleImmediate(constant->getValue()));
+        }
+        if (frameOffset(inst.getSecond(), offset) && promoted.count(offset))
+            inst.setSecond(promoted[offset]);
+    }
+}
+
+void T86::FrameOptimiser::shareSlots(T86Program &program) {
+    for (std::size_t i = 0; i < program.getFunctions().size(); ++i)
+        shareFunction(program, i);
+}
+
+void T86::FrameOptimiser::shareFunction(T86Program &program, std::size_t function) {
+    auto &code = program.getInstructions();
+    auto &info = program.getFunctions()[function];
+    auto begin = info.begin, n = program.functionEnd(function) - begin;
+    auto &objects = info.frame_objects;
+    auto m = objects.size();
+
+    // word of the frame -> object
+    std::map<long long, std::size_t> owner;
+    for (std::size_t o = 0; o < m; ++o)
+        for (long long w = 0; w < objects[o].second; ++w)
+            owner[objects[o].first - w] = o;
+
+    // objects, which are read by the instruction (or accessed partially), and the one, which is overwritten
+    std::vector<std::vector<std::size_t>> uses(n);
+    std::vector<long long> kills(n, -1);
+    std::vector<bool> accessed(m), escaped(m);
+
+    for (std::size_t k = 0; k < n; ++k) {
+        auto &inst = code[begin + k];
+        auto op = inst.getOpcode();
+        std::array<Operand *, 2> operands = {inst.getFirst(), inst.getSecond()};
+
+        for (std::size_t j = 0; j < 2; ++j) {
+            if (isRegister(operands[j], Register::BP) && op != Instruction::PUSH && op != Instruction::POP &&
+                !(op == Instruction::MOV && j == 0 && isRegister(operands[1], Register::SP)))
+                return;
+
+            long long offset;
+            if (!frameOffset(operands[j], offset) || offset >= 0)
+                continue;
+            auto o = owner.find(offset);
+            // word, which does not belong to any object -- layout of the frame is not known
+            if (o == owner.end())
+                return;
+
+            accessed[o->second] = true;
+            if (op == Instruction::LEA)
+                escaped[o->second] = true;
+            else if (j == 0 && op == Instruction::MOV && objects[o->second].second == 1)
+                kills[k] = (long long) o->second;
+            else
+                uses[k].emplace_back(o->second);
+        }
+    }
+
+    // liveness of the objects, iterates backward till the fixpoint
+    Liveness control(program, function);
+    std::vector<std::vector<bool>> live_in(n, std::vector<bool>(m)), live_out(n, std::vector<bool>(m));
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (long long k = n - 1; k >= 0; --k) {
+            std::vector<bool> out(m);
+            for (auto s: control.successors[k])
+                for (std::size_t o = 0; o < m; ++o)
+                    if (live_in[s][o])
+                        out[o] = true;
+
+            auto in = out;
+            if (kills[k] >= 0)
+                in[kills[k]] = false;
+            for (auto o: uses[k])
+                in[o] = true;
+
+            if (in != live_in[k] || out != live_out[k]) {
+                live_in[k] = std::move(in);
+                live_out[k] = std::move(out);
+                changed = true;
+            }
+        }
+    }
+
+    // objects alive at the same point interfere, the one with the taken address interferes with everything
+    std::vector<std::vector<bool>> interfere(m, std::vector<bool>(m));
+    auto together = [&](const std::vector<bool> &alive) {
+        for (std::size_t a = 0; a < m; ++a)
+            for (std::size_t b = 0; b < m; ++b)
+                if (alive[a] && alive[b])
+                    interfere[a][b] = true;
+    };
+    for (std::size_t k = 0; k < n; ++k) {
+        together(live_in[k]);
+        auto alive = live_out[k];
+        if (kills[k] >= 0)
+            alive[kills[k]] = true;
+        together(alive);
+    }
+    for (std::size_t a = 0; a < m; ++a)
+        for (std::size_t b = 0; b < m; ++b)
+            if (escaped[a] || escaped[b])
+                interfere[a][b] = true;
+
+    // the biggest objects first, each to the highest place, where it does not overlap the interfering ones
+    std::vector<std::size_t> order;
+    for (std::size_t o = 0; o < m; ++o)
+        if (accessed[o])
+            order.emplace_back(o);
+    std::stable_sort(order.begin(), order.end(), [&objects](std::size_t a, std::size_t b) {
+        return objects[a].second > objects[b].second;
+    });
+
+    std::vector<long long> new_place(m);
+    std::vector<std::size_t> placed;
+    long long frame_size = 0;
+    for (auto o: order) {
+        auto size = objects[o].second;
+        auto overlaps = [&](long long top) {
+            for (auto p: placed)
+                if (interfere[o][p] && top - size < new_place[p] && new_place[p] - objects[p].second < top)
+                    return true;
+            return false;
+        };
+        long long top = -1;
+        while (overlaps(top))
+            --top;
+        new_place[o] = top;
+        placed.emplace_back(o);
+        frame_size = std::max(frame_size, size - top - 1);
+    }
+
+    for (std::size_t k = 0; k < n; ++k) {
+        auto &inst = code[begin + k];
+        long long offset;
+        if (frameOffset(inst.getFirst(), offset) && offset < 0) {
+            auto o = owner[offset];
+            inst.setFirst(Memory(Register(Register::BP, offset - objects[o].first + new_place[o])));
+        }
+        if (frameOffset(inst.getSecond(), offset) && offset < 0) {
+            auto o = owner[offset];
+            inst.setSecond(Memory(Register(Register::BP, offset - objects[o].first + new_place[o])));
+        }
+    }
+
+    std::vector<std::pair<long long, long long>> new_objects;
+    for (auto o: order)
+        new_objects.emplace_back(new_place[o], objects[o].second);
+    objects = std::move(new_objects);
+    program.setFrameSize(function, frame_size);
+}
+
+void T86::FrameOptimiser::omitFrames(T86Program &program) {
+    auto &code = program.getInstructions();
+    std::vector<bool> removed(code.size());
+
+    for (std::size_t i = 0; i < program.getFunctions().size(); ++i)
+        omitFrame(program, i, removed);
+
+    std::vector<Instruction> new_code;
+    std::vector<std::size_t> new_place(code.size() + 1);
+    for (std::size_t i = 0; i < code.size(); ++i) {
+        // removed instruction is replaced by the next one
+        new_place[i] = new_code.size();
+        if (!removed[i])
+            new_code.push_back(std::move(code[i]));
+    }
+    new_place[code.size()] = new_code.size();
+    program.relocate(std::move(new_code), new_place);
+}
+
+void T86::FrameOptimiser::omitFrame(T86Program &program, std::size_t function, std::vector<bool> &removed) {
+    auto &code = program.getInstructions();
+    auto begin = program.getFunctions()[function].begin, end = program.functionEnd(function);
+
+    // PUSH BP; MOV BP,SP; SUB SP,n; PUSH saved registers
+    if (end - begin < 2 || code[begin].getOpcode() != Instruction::PUSH ||
+        !isRegister(code[begin].getFirst(), Register::BP) || code[begin + 1].getOpcode() != Instruction::MOV ||
+        !isRegister(code[begin + 1].getFirst(), Register::BP) || !isRegister(code[begin + 1].getSecond(), Register::SP))
+        return;
+
+    // instructions, which maintain BP, and the ones, which allocate and free the frame
+    std::set<std::size_t> chain = {begin, begin + 1}, allocation;
+
+    long long frame_size = 0;
+    auto body = begin + 2;
+    if (body < end && code[body].getOpcode() == Instruction::SUB && isRegister(code[body].getFirst(), Register::SP))
+        if (auto size = code[body].getSecond(); size && size->isIntImmediate()) {
+            frame_size = size->getValue();
+            allocation.insert(body++);
+        }
+
+    // POP saved registers; ADD SP,n; POP BP; RET
+    for (auto k = begin; k < end; ++k) {
+        if (code[k].getOpcode() != Instruction::RET)
+            continue;
+        if (k < begin + 1 || code[k - 1].getOpcode() != Instruction::POP ||
+            !isRegister(code[k - 1].getFirst(), Register::BP))
+            return;
+        chain.insert(k - 1);
+        if (code[k - 2].getOpcode() == Instruction::ADD && isRegister(code[k - 2].getFirst(), Register::SP))
+            allocation.insert(k - 2);
+    }
+
+    bool uses_frame = false, leaf = true;
+    for (auto k = begin; k < end; ++k) {
+        if (chain.count(k) || allocation.count(k))
+            continue;
+        auto &inst = code[k];
+        auto op = inst.getOpcode();
+        for (auto operand: {inst.getFirst(), inst.getSecond()}) {
+            if (!operand)
+                continue;
+            if (isFramePointer(operand))
+                uses_frame = true;
+            if (isStackPointer(operand))
+                leaf = false;
+
+            // BP itself as the value
+            long long offset;
+            if (isFramePointer(operand) && (!frameOffset(operand, offset) || offset == 0 || offset == 1))
+                return;
+        }
+        if (op == Instruction::CALL)
+            leaf = false;
+    }
+
+    if (!uses_frame) {
+        for (auto k: chain)
+            removed[k] = true;
+        for (auto k: allocation)
+            removed[k] = true;
+        return;
+    }
+
+    if (!leaf)
+        return;
+
+    // only the saved registers are pushed (right after the allocation) and popped (before the release)
+    long long saved = 0;
+    for (auto k = body; k < end && (code[k].getOpcode() == Instruction::PUSH ||
+                                    code[k].getOpcode() == Instruction::FPUSH); ++k)
+        saved++;
+    long long pushes = 0;
+    for (auto k = begin; k < end; ++k)
+        if (code[k].getOpcode() == Instruction::PUSH || code[k].getOpcode() == Instruction::FPUSH)
+            pushes++;
+    if (pushes != saved + 1)
+        return;
+
+    // SP stays the same in the whole body. Without the pushed BP locals are right above it and arguments
+    // are one word closer
+    for (auto k = begin; k < end; ++k) {
+        if (chain.count(k))
+            continue;
+        auto &inst = code[k];
+        long long offset;
+        if (frameOffset(inst.getFirst(), offset))
+            inst.setFirst(Memory(Register(Register::SP, (offset < 0 ? offset : offset - 1) + frame_size + saved)));
+        if (frameOffset(inst.getSecond(), offset))
+            inst.setSecond(Memory(Register(Register::SP, (offset < 0 ? offset : offset - 1) + frame_size + saved)));
+    }
+
+    for (auto k: chain)
+        removed[k] = true;
+}
+
+bool T86::FrameOptimiser::isFramePointer(Operand *operand) {
+    return operand && (operand->isRegister() || operand->isMemory()) && operand->getNumber() == Register::BP;
+}
+
+bool T86::FrameOptimiser::frameOffset(Operand *operand, long long &offset) {
+    if (!operand || !operand->isMemory() || operand->getNumber() != Register::BP)
+        return false;
+    offset = operand->getOffset();
+    return true;
+}
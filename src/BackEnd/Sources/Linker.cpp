@@ -0,0 +1,66 @@
+#include "Linker.h"
+
+#include <stdexcept>
+
+T86::Linker::Linker(Writer &new_out) : out(new_out) {}
+
+void T86::Linker::write(T86Program &program) {
+    if (!written) {
+        if (!program.getData().empty()) {
+            out << ".data\n";
+            for (auto &i: program.getData()) {
+                i.print(out);
+                out << '\n';
+            }
+        }
+        out << ".text\n";
+    }
+
+    auto base = written;
+    for (auto &i: program.getFunctions()) {
+        auto address = base + i.begin;
+        addresses[i.name] = address;
+
+        // fill in the calls, which have been waiting for the function
+        auto waiting = relocations.find(i.name);
+        if (waiting == relocations.end())
+            continue;
+        auto text = std::to_string(address);
+        for (auto place: waiting->second)
+            out.patch(place, text);
+        relocations.erase(waiting);
+    }
+
+    auto &externals = program.getExternals();
+    for (auto inst: program.getInstructions()) {
+        out << written++ << ' ';
+
+        auto target = inst.getFirst();
+        if (Instruction::isBranch(inst.getOpcode()) && target && target->isIntImmediate()) {
+            if (target->getValue() >= 0) {
+                target->addValue(target->getValue() + (long long) base);
+            } else {
+                auto &name = externals[-1 - target->getValue()].name;
+                auto address = addresses.find(name);
+                if (address != addresses.end()) {
+                    inst.setFirst(IntImmediate((long long) address->second));
+                } else {
+                    inst.setFirst(IntImmediate());
+                    inst.print(out);
+                    // the blank replaces the printed 0
+                    relocations[name].emplace_back(out.position() - 1);
+                    out << std::string(field - 1, ' ') << '\n';
+                    continue;
+                }
+            }
+        }
+
+        inst.print(out);
+        out << '\n';
+    }
+}
+
+void T86::Linker::finish() {
+    if (!relocations.empty())
+        throw std::invalid_argument("ERROR. Function " + relocations.begin()->first + " is not defined.");
+}
@@ -0,0 +1,133 @@
+#include "Liveness.h"
+
+T86::Liveness::Liveness(T86Program &program, std::size_t function, bool new_floating) : floating(new_floating) {
+    auto &code = program.getInstructions();
+    auto &info = program.getFunctions()[function];
+    auto begin = info.begin, end = program.functionEnd(function);
+    auto &convention = program.getCallingConvention();
+    argument_registers = floating ? convention.float_registers : convention.registers;
+
+    auto n = end - begin;
+    uses.assign(n, {});
+    defs.assign(n, -1);
+    clobbers.assign(n, {});
+    move_source.assign(n, -1);
+    loop_depth.assign(n, 0);
+    successors.assign(n, {});
+
+    for (std::size_t k = 0; k < n; ++k) {
+        auto &inst = code[begin + k];
+        auto op = inst.getOpcode();
+
+        if (inst.getFirst()) {
+            auto reg = denseNumber(inst.getFirst());
+            if (reg >= 0) {
+                if (inst.getFirst()->isMemory())
+                    uses[k].emplace_back(reg);
+                else {
+                    if (Instruction::readsFirst(op))
+                        uses[k].emplace_back(reg);
+                    if (Instruction::writesFirst(op))
+                        defs[k] = reg;
+                }
+            }
+        }
+        if (inst.getSecond()) {
+            auto reg = denseNumber(inst.getSecond());
+            if (reg >= 0) {
+                uses[k].emplace_back(reg);
+                if (op == Instruction::MOV && defs[k] >= 0 && inst.getSecond()->isRegister())
+                    move_source[k] = reg;
+            }
+        }
+
+        // call reads the arguments of the callee and destroys all argument registers, RET reads the result
+        if (op == Instruction::CALL && argument_registers)
+            if (auto target = inst.getFirst(); target && target->isIntImmediate()) {
+                auto callee = program.functionAt(target->getValue());
+                auto arguments = callee ? (floating ? callee->float_register_arguments
+                                                    : callee->register_arguments) : argument_registers;
+                for (std::size_t r = 0; r < arguments; ++r)
+                    uses[k].emplace_back(denseNumber(r));
+                for (std::size_t r = 0; r < argument_registers; ++r)
+                    clobbers[k].emplace_back(denseNumber(r));
+            }
+        if (op == Instruction::RET && (floating ? info.float_register_result : info.register_result))
+            uses[k].emplace_back(denseNumber((std::size_t) 0));
+
+        if (Instruction::isBranch(op) && op != Instruction::CALL)
+            if (auto target = inst.getFirst(); target && target->isIntImmediate())
+                if (target->getValue() >= (long long) begin && target->getValue() < (long long) end) {
+                    successors[k].emplace_back(target->getValue() - begin);
+                    // jump backward closes a loop
+                    for (auto j = target->getValue() - begin; j <= k; ++j)
+                        loop_depth[j]++;
+                }
+        if (!Instruction::isTerminator(op) && k + 1 < n)
+            successors[k].emplace_back(k + 1);
+    }
+
+    // iterates backward till the fixpoint
+    auto number_of_regs = to_dense.size();
+    live_in.assign(n, std::vector<bool>(number_of_regs));
+    live_out.assign(n, std::vector<bool>(number_of_regs));
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (long long k = n - 1; k >= 0; --k) {
+            std::vector<bool> out(number_of_regs);
+            for (auto s: successors[k])
+                for (std::size_t r = 0; r < number_of_regs; ++r)
+                    if (live_in[s][r])
+                        out[r] = true;
+
+            auto in = out;
+            if (defs[k] >= 0)
+                in[defs[k]] = false;
+            for (auto r: clobbers[k])
+                in[r] = false;
+            for (auto r: uses[k])
+                in[r] = true;
+
+            if (in != live_in[k] || out != live_out[k]) {
+                live_in[k] = std::move(in);
+                live_out[k] = std::move(out);
+                changed = true;
+            }
+        }
+    }
+}
+
+long long T86::Liveness::registerNumber(Operand *operand) {
+    if (!operand)
+        return -1;
+    if (floating)
+        return operand->isFRegister() ? (long long) operand->getNumber() : -1;
+
+    if ((!operand->isRegister() && !operand->isMemory()) || operand->isSpecial())
+        return -1;
+    return operand->getNumber();
+}
+
+long long T86::Liveness::denseNumber(Operand *operand) {
+    auto reg = registerNumber(operand);
+    if (reg < 0)
+        return -1;
+    return (long long) denseNumber((std::size_t) reg);
+}
+
+std::size_t T86::Liveness::denseNumber(std::size_t reg) {
+    return to_dense.emplace(reg, to_dense.size()).first->second;
+}
+
+bool T86::Liveness::isLiveAfter(std::size_t reg, std::size_t position) {
+    auto dense = to_dense.find(reg);
+    if (dense == to_dense.end())
+        return false;
+    return live_out[position][dense->second];
+}
+
+std::size_t T86::Liveness::numberOfRegisters() {
+    return to_dense.size();
+}
@@ -1,73 +1,184 @@
 #include "Operands.h"
 
+#include <stdexcept>
 
-T86::IntImmediate::IntImmediate(long long new_value) : value(new_value) {}
 
-void T86::IntImmediate::addValue(long long new_value) {
-    value = new_value;
+T86::Operand::Kind T86::Operand::getKind() const {
+    return kind;
+}
+
+bool T86::Operand::isIntImmediate() const {
+    return kind == INT;
+}
+
+bool T86::Operand::isDoubleImmediate() const {
+    return kind == DOUBLE;
+}
+
+bool T86::Operand::isRegister() const {
+    return kind == REGISTER;
+}
+
+bool T86::Operand::isFRegister() const {
+    return kind == FREGISTER;
+}
+
+bool T86::Operand::isMemory() const {
+    return kind == MEMORY;
 }
 
-std::string T86::IntImmediate::toString() {
-    return std::to_string(value);
+long long T86::Operand::getValue() const {
+    return value;
 }
 
-std::unique_ptr<T86::Operand> T86::IntImmediate::clone() const {
-    return std::make_unique<T86::IntImmediate>(*this);
+void T86::Operand::addValue(long long new_value) {
+    value = new_value;
 }
 
-T86::DoubleImmediate::DoubleImmediate(double new_value) : value(new_value) {}
+double T86::Operand::getReal() const {
+    return real;
+}
 
-std::string T86::DoubleImmediate::toString() {
-    return std::to_string(value);
+std::size_t T86::Operand::getNumber() const {
+    return number;
 }
 
-std::unique_ptr<T86::Operand> T86::DoubleImmediate::clone() const {
-    return std::make_unique<T86::DoubleImmediate>(*this);
+void T86::Operand::setNumber(std::size_t new_number) {
+    number = new_number;
 }
 
+long long T86::Operand::getOffset() const {
+    return kind == REGISTER || kind == MEMORY ? value : 0;
+}
 
-T86::Register::Register(std::size_t new_reg, long long new_offset) : register_number(new_reg), offset(new_offset) {}
+bool T86::Operand::isSpecial() const {
+    if (kind != REGISTER && kind != MEMORY)
+        return false;
+    return number == Register::BP || number == Register::SP || number == Register::IP ||
+           number == Register::NO_REGISTER;
+}
 
-std::string T86::Register::toString() {
-    std::string res;
-    if (register_number == BP)
-        res = "BP";
-    else if (register_number == SP)
-        res = "SP";
-    else if (register_number == IP)
-        res = "IP";
-    else
-        res = 'R' + std::to_string(register_number);
+bool T86::Operand::isAbsolute() const {
+    return kind == MEMORY && number == Register::NO_REGISTER;
+}
 
-    if (offset != 0)
-        res += " + " + std::to_string(offset);
-    return res;
+T86::Operand T86::Operand::getAddr() const {
+    if (isAbsolute())
+        return IntImmediate(value);
+    return Register(number, value);
 }
 
-std::unique_ptr<T86::Operand> T86::Register::clone() const {
-    return std::make_unique<T86::Register>(*this);
+bool T86::Operand::operator==(const Operand &other) const {
+    if (kind != other.kind)
+        return false;
+    switch (kind) {
+        case NONE:
+            return true;
+        case INT:
+            return value == other.value;
+        case DOUBLE:
+            return real == other.real;
+        case FREGISTER:
+            return number == other.number;
+        default:
+            return number == other.number && value == other.value;
+    }
 }
 
-T86::FRegister::FRegister(std::size_t new_reg) : reg_number(new_reg) {}
+std::string T86::Operand::toString() const {
+    switch (kind) {
+        case INT:
+            return std::to_string(value);
+        case DOUBLE:
+            return std::to_string(real);
+        case FREGISTER:
+            return "F" + std::to_string(number);
+        case MEMORY:
+            return '[' + getAddr().toString() + ']';
+        case REGISTER: {
+            std::string res;
+            if (number == Register::BP)
+                res = "BP";
+            else if (number == Register::SP)
+                res = "SP";
+            else if (number == Register::IP)
+                res = "IP";
+            else
+                res = 'R' + std::to_string(number);
+
+            if (value != 0)
+                res += " + " + std::to_string(value);
+            return res;
+        }
+        default:
+            return "";
+    }
+}
 
-std::string T86::FRegister::toString() {
-    return "F" + std::to_string(reg_number);
+void T86::Operand::print(Writer &out) const {
+    switch (kind) {
+        case INT:
+            out << value;
+            break;
+        case DOUBLE:
+            out << real;
+            break;
+        case FREGISTER:
+            out << 'F' << std::size_t(number);
+            break;
+        case MEMORY:
+            out << '[';
+            getAddr().print(out);
+            out << ']';
+            break;
+        case REGISTER:
+            if (number == Register::BP)
+                out << "BP";
+            else if (number == Register::SP)
+                out << "SP";
+            else if (number == Register::IP)
+                out << "IP";
+            else
+                out << 'R' << std::size_t(number);
+
+            if (value != 0)
+                out << " + " << value;
+            break;
+        default:
+            break;
+    }
 }
 
-std::unique_ptr<T86::Operand> T86::FRegister::clone() const {
-    return std::make_unique<T86::FRegister>(*this);
+T86::IntImmediate::IntImmediate(long long new_value) {
+    kind = INT;
+    value = new_value;
 }
 
-T86::Memory::Memory(std::unique_ptr<Operand> &&new_addr) : addr(std::move(new_addr)) {}
+T86::DoubleImmediate::DoubleImmediate(double new_value) {
+    kind = DOUBLE;
+    real = new_value;
+}
 
-std::string T86::Memory::toString() {
-    return '[' + addr->toString() + ']';
+T86::Register::Register(std::size_t new_reg, long long new_offset) {
+    kind = REGISTER;
+    number = new_reg;
+    value = new_offset;
 }
 
-T86::Memory::Memory(const Memory&old_mem){
-    addr = old_mem.addr->clone();
+T86::FRegister::FRegister(std::size_t new_reg) {
+    kind = FREGISTER;
+    number = new_reg;
 }
 
-std::unique_ptr<T86::Operand> T86::Memory::clone() const {
-    return std::make_unique<T86::Memory>(*this);
-}
\ No newline at end of file
+T86::Memory::Memory(const Operand &address) {
+    kind = MEMORY;
+    if (address.isIntImmediate()) {
+        number = Register::NO_REGISTER;
+        value = address.getValue();
+        return;
+    }
+    if (!address.isRegister())
+        throw std::invalid_argument("ERROR. Address of the memory has to be in a register or an immediate.");
+    number = address.getNumber();
+    value = address.getOffset();
+}
@@ -0,0 +1,279 @@
+#include "Peephole.h"
+
+namespace {
+    using T86::Instruction;
+
+    // variables of the patterns
+    enum {
+        A, B, C
+    };
+
+    const std::set<Instruction::Opcode> conditional_jumps = {
+            Instruction::JZ, Instruction::JNZ, Instruction::JE, Instruction::JNE, Instruction::JG, Instruction::JGE,
+            Instruction::JL, Instruction::JLE, Instruction::JA, Instruction::JAE, Instruction::JB, Instruction::JBE,
+            Instruction::JO, Instruction::JNO, Instruction::JS, Instruction::JNS
+    };
+
+    // instructions, which only read their second operand
+    const std::set<Instruction::Opcode> arithmetic = {
+            Instruction::ADD, Instruction::SUB, Instruction::MUL, Instruction::DIV, Instruction::IMUL,
+            Instruction::IDIV, Instruction::AND, Instruction::OR, Instruction::XOR, Instruction::LSH,
+            Instruction::RSH, Instruction::CMP
+    };
+
+    template<typename... Args>
+    std::vector<Instruction> sequence(Args &&... args) {
+        std::vector<Instruction> res;
+        (res.push_back(std::move(args)), ...);
+        return res;
+    }
+
+    T86::Operand stack() {
+        return T86::Register(T86::Register::SP);
+    }
+}
+
+T86::Peephole::Peephole() {
+    rules = {
+            // ADD SP,0 -- function without locals, call without arguments
+            {"zero-stack-adjust",
+             {{{Instruction::ADD, Instruction::SUB}, {STACK}, {IMM, A}}},
+             {{ZERO, A}},
+             [](Match &) { return sequence(); }},
+
+            {"self-move",
+             {{{Instruction::MOV}, {REG, A}, {REG, A}}},
+             {},
+             [](Match &) { return sequence(); }},
+
+            {"jump-to-next",
+             {{{Instruction::JMP}, {IMM, A}}},
+             {{NEXT, A}},
+             [](Match &) { return sequence(); }},
+
+            // Jcc over the JMP -- jump by the opposite condition
+            {"jump-over-jump",
+             {{conditional_jumps, {IMM, A}},
+              {{Instruction::JMP}, {IMM, B}}},
+             {{NEXT, A}},
+             [](Match &m) {
+                 return sequence(Instruction(Instruction::invertCondition(m.window[0]->getOpcode()), m.take(B)));
+             }},
+
+            // MOV Rn,X; MOV Rm,Rn
+            {"copy-propagation",
+             {{{Instruction::MOV}, {REG, A}, {ANY, B}},
+              {{Instruction::MOV}, {REG, C}, {REG, A}}},
+             {{DEAD, A}, {DIFFERENT, A, C}},
+             [](Match &m) { return sequence(Instruction(Instruction::MOV, m.take(C), m.take(B))); }},
+
+            // MOV Rn,X; MOV [..],Rn
+            {"store-forwarding",
+             {{{Instruction::MOV}, {REG, A}, {VALUE, B}},
+              {{Instruction::MOV}, {MEM, C}, {REG, A}}},
+             {{DEAD, A}, {NOT_BASED_ON, C, A}},
+             [](Match &m) { return sequence(Instruction(Instruction::MOV, m.take(C), m.take(B))); }},
+
+            // MOV Rn,X; ADD Rm,Rn
+            {"operand-forwarding",
+             {{{Instruction::MOV}, {REG, A}, {VALUE, B}},
+              {arithmetic, {REG, C}, {REG, A}}},
+             {{DEAD, A}, {DIFFERENT, A, C}},
+             [](Match &m) { return sequence(Instruction(m.window[1]->getOpcode(), m.take(C), m.take(B))); }},
+
+            {"push-forwarding",
+             {{{Instruction::MOV}, {REG, A}, {VALUE, B}},
+              {{Instruction::PUSH}, {REG, A}}},
+             {{DEAD, A}},
+             [](Match &m) { return sequence(Instruction(Instruction::PUSH, m.take(B))); }},
+
+            // result of the call is not used -- free its place together with the arguments
+            {"unused-call-result",
+             {{{Instruction::CALL}, {ANY, A}},
+              {{Instruction::ADD}, {STACK}, {IMM, B}},
+              {{Instruction::POP}, {REG, C}}},
+             {{DEAD, C}},
+             [](Match &m) {
+                 return sequence(Instruction(Instruction::CALL, m.take(A)),
+                                 Instruction(Instruction::ADD, stack(), IntImmediate(m.value(B) + 1)));
+             }}
+    };
+}
+
+void T86::Peephole::run(T86Program &program) {
+    while (sweep(program));
+}
+
+void T86::Peephole::printReport(std::ostream &oss) {
+    oss << "rule fired" << std::endl;
+    for (auto &i: rules)
+        oss << i.name << ' ' << i.fired << std::endl;
+}
+
+void T86::Peephole::merge(const Peephole &other) {
+    for (std::size_t i = 0; i < rules.size(); ++i)
+        rules[i].fired += other.rules[i].fired;
+}
+
+bool T86::Peephole::sweep(T86Program &program) {
+    auto &code = program.getInstructions();
+    auto &functions = program.getFunctions();
+
+    // window can not continue over the instruction, where some jump lands
+    std::vector<bool> is_target(code.size() + 1);
+    for (auto &i: code)
+        if (Instruction::isBranch(i.getOpcode()))
+            if (auto target = i.getFirst(); target && target->isIntImmediate())
+                if (target->getValue() >= 0 && target->getValue() < (long long) code.size())
+                    is_target[target->getValue()] = true;
+
+    // code before the first function and the functions themselves
+    std::vector<std::size_t> bounds = {0};
+    for (auto &i: functions) {
+        bounds.emplace_back(i.begin);
+        is_target[i.begin] = true;
+    }
+    bounds.emplace_back(code.size());
+
+    std::vector<Instruction> new_code;
+    std::vector<std::size_t> new_place(code.size() + 1);
+    bool changed = false;
+
+    for (std::size_t piece = 0; piece + 1 < bounds.size(); ++piece) {
+        auto begin = bounds[piece], end = bounds[piece + 1];
+
+        Liveness function_liveness;
+        liveness = nullptr;
+        if (piece > 0) {
+            function_liveness = Liveness(program, piece - 1);
+            liveness = &function_liveness;
+        }
+        function_begin = begin;
+
+        for (auto i = begin; i < end;) {
+            Rule *fired = nullptr;
+            Match m;
+            for (auto &rule: rules) {
+                auto size = rule.pattern.size();
+                if (i + size > end)
+                    continue;
+
+                bool crosses_target = false;
+                for (auto j = i + 1; j < i + size; ++j)
+                    if (is_target[j])
+                        crosses_target = true;
+                if (crosses_target)
+                    continue;
+
+                m = Match();
+                if (match(rule, code, i, m)) {
+                    fired = &rule;
+                    break;
+                }
+            }
+
+            if (!fired) {
+                new_place[i] = new_code.size();
+                new_code.push_back(std::move(code[i]));
+                ++i;
+                continue;
+            }
+
+            auto size = fired->pattern.size();
+            for (auto j = i; j < i + size; ++j)
+                new_place[j] = new_code.size();
+            for (auto &inst: fired->replace(m))
+                new_code.push_back(std::move(inst));
+
+            fired->fired++;
+            changed = true;
+            i += size;
+        }
+    }
+    liveness = nullptr;
+
+    new_place[code.size()] = new_code.size();
+    program.relocate(std::move(new_code), new_place);
+    return changed;
+}
+
+bool T86::Peephole::match(Rule &rule, std::vector<Instruction> &code, std::size_t position, Match &m) {
+    for (std::size_t j = 0; j < rule.pattern.size(); ++j) {
+        auto &inst = code[position + j];
+        auto &pattern = rule.pattern[j];
+        if (!pattern.opcodes.count(inst.getOpcode()) || !matchOperand(pattern.first, inst.getFirst(), m) ||
+            !matchOperand(pattern.second, inst.getSecond(), m))
+            return false;
+        m.window.emplace_back(&inst);
+    }
+
+    for (auto &i: rule.constraints)
+        if (!satisfies(i, position, rule.pattern.size(), m))
+            return false;
+    return true;
+}
+
+bool T86::Peephole::matchOperand(const OperandPattern &pattern, Operand *operand, Match &m) {
+    bool general = operand && operand->isRegister() && !operand->isSpecial() && !operand->getOffset();
+
+    bool fits = false;
+    switch (pattern.kind) {
+        case NONE:
+            return !operand;
+        case ANY:
+            fits = operand;
+            break;
+        case REG:
+            fits = general;
+            break;
+        case VALUE:
+            fits = general || (operand && operand->isIntImmediate());
+            break;
+        case IMM:
+            fits = operand && operand->isIntImmediate();
+            break;
+        case MEM:
+            fits = operand && operand->isMemory();
+            break;
+        case STACK:
+            fits = operand && operand->isRegister() && operand->getNumber() == Register::SP && !operand->getOffset();
+            break;
+    }
+
+    if (!fits || pattern.var < 0)
+        return fits;
+
+    auto &bound = m.vars[pattern.var];
+    if (!bound) {
+        bound = operand;
+        return true;
+    }
+    return *bound == *operand;
+}
+
+bool T86::Peephole::satisfies(const Constraint &constraint, std::size_t position, std::size_t size, Match &m) {
+    auto operand = m.vars[constraint.var];
+    switch (constraint.kind) {
+        case DEAD:
+            // outside of the functions nothing is known
+            return liveness && !liveness->isLiveAfter(operand->getNumber(),
+                                                      position + size - 1 - function_begin);
+        case DIFFERENT:
+            return !(*operand == *m.vars[constraint.other]);
+        case NOT_BASED_ON:
+            return operand->isSpecial() || operand->getNumber() != m.vars[constraint.other]->getNumber();
+        case ZERO:
+            return m.value(constraint.var) == 0;
+        case NEXT:
+            return m.value(constraint.var) == (long long) (position + size);
+    }
+    return false;
+}
+
+T86::Operand T86::Peephole::Match::take(int var) {
+    return *vars[var];
+}
+
+long long T86::Peephole::Match::value(int var) {
+    return vars[var]->getValue();
+}
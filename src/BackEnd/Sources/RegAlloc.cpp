@@ -0,0 +1,736 @@
+#include "RegAlloc.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+T86::RegisterAllocator::RegisterAllocator(std::size_t new_number, std::size_t new_float_number)
+        : number_of_registers(new_number), number_of_float_registers(new_float_number) {}
+
+void T86::RegisterAllocator::run(T86Program &program, Profiler *new_profiler) {
+    profiler = new_profiler;
+    floating = false;
+    allocateFile(program);
+    floating = true;
+    allocateFile(program);
+}
+
+void T86::RegisterAllocator::allocateFile(T86Program &program) {
+    auto &code = program.getInstructions();
+    auto &functions = program.getFunctions();
+
+    std::vector<Instruction> new_code;
+    std::vector<std::size_t> new_place(code.size() + 1);
+
+    // code before the first function (call of the main) stays as it is
+    auto first_function = functions.empty() ? code.size() : functions[0].begin;
+    for (std::size_t i = 0; i < first_function; ++i) {
+        new_place[i] = new_code.size();
+        new_code.push_back(std::move(code[i]));
+    }
+
+    std::vector<long long> spills;
+    for (std::size_t i = 0; i < functions.size(); ++i) {
+        Profiler::Span span(profiler, floating ? functions[i].name + " (float)" : functions[i].name);
+        spills.emplace_back(allocateFunction(program, i, new_code, new_place));
+    }
+
+    new_place[code.size()] = new_code.size();
+    program.relocate(std::move(new_code), new_place);
+
+    // spilled registers extend the frame
+    for (std::size_t i = 0; i < functions.size(); ++i)
+        program.setFrameSize(i, functions[i].frame_size + spills[i]);
+}
+
+void T86::RegisterAllocator::printReport(std::ostream &oss) {
+    oss << "function instructions spilled rematerialised coalesced" << std::endl;
+    // general register file goes first
+    for (auto floating: {false, true})
+        for (auto &i: statistics)
+            if (i.floating == floating)
+                oss << i.name << ' ' << i.instructions << ' ' << i.spilled << ' ' << i.rematerialised << ' '
+                    << i.coalesced << std::endl;
+}
+
+void T86::RegisterAllocator::merge(const RegisterAllocator &other) {
+    statistics.insert(statistics.end(), other.statistics.begin(), other.statistics.end());
+}
+
+std::vector<T86::RegisterAllocator::Interval>
+T86::RegisterAllocator::analyse(T86Program &program, std::size_t function) {
+    auto &code = program.getInstructions();
+    auto begin = program.getFunctions()[function].begin;
+    auto n = program.functionEnd(function) - begin;
+    liveness = Liveness(program, function, floating);
+    auto number_of_regs = liveness.numberOfRegisters();
+    auto &uses = liveness.uses;
+    auto &defs = liveness.defs;
+    auto &live_in = liveness.live_in;
+    auto &live_out = liveness.live_out;
+
+    // intervals
+    std::vector<Interval> res(number_of_regs);
+    std::vector<std::size_t> number_of_defs(number_of_regs), place_of_def(number_of_regs);
+    for (std::size_t r = 0; r < number_of_regs; ++r) {
+        res[r].reg = r;
+        res[r].start = n;
+    }
+
+    auto touch = [&](std::size_t reg, std::size_t k) {
+        res[reg].start = std::min(res[reg].start, k);
+        res[reg].end = std::max(res[reg].end, k);
+    };
+
+    for (std::size_t k = 0; k < n; ++k) {
+        for (std::size_t r = 0; r < number_of_regs; ++r)
+            if (live_in[k][r] || live_out[k][r])
+                touch(r, k);
+        for (auto r: uses[k])
+            touch(r, k);
+        if (defs[k] >= 0) {
+            touch(defs[k], k);
+            number_of_defs[defs[k]]++;
+            place_of_def[defs[k]] = k;
+        }
+    }
+
+    for (auto &i: res) {
+        // registers of the convention might be never touched by the function
+        i.starts_with_def = i.start < n && defs[i.start] == (long long) i.reg;
+
+        auto &def = code[begin + place_of_def[i.reg]];
+        if (!floating && number_of_defs[i.reg] == 1 && !live_in[0][i.reg] && def.getOpcode() == Instruction::MOV)
+            if (auto constant = def.getSecond(); constant && constant->isIntImmediate()) {
+                i.remat = true;
+                i.constant = constant->getValue();
+            }
+
+        if (i.starts_with_def)
+            i.hint = liveness.move_source[i.start];
+    }
+
+    // argument registers keep their numbers
+    for (auto &[number, dense]: liveness.to_dense)
+        if (number < liveness.argument_registers) {
+            res[dense].fixed = (long long) number;
+            res[dense].remat = false;
+        }
+
+    // virtual register can not be placed into the argument register, which is written while it is alive,
+    // or which holds the argument, when the function starts
+    for (std::size_t r = 0; r < number_of_regs; ++r)
+        for (std::size_t p = 0; p < number_of_regs; ++p)
+            if (live_in[0][r] && live_in[0][p] && res[r].fixed < 0 && res[p].fixed >= 0)
+                res[r].forbidden.insert(res[p].fixed);
+
+    for (std::size_t k = 0; k < n; ++k) {
+        auto written = liveness.clobbers[k];
+        if (defs[k] >= 0)
+            written.emplace_back(defs[k]);
+
+        for (auto d: written)
+            for (std::size_t r = 0; r < number_of_regs; ++r) {
+                if (!live_out[k][r] || r == d || ((long long) d == defs[k] && (long long) r == liveness.move_source[k]))
+                    continue;
+                if (res[d].fixed >= 0 && res[r].fixed < 0)
+                    res[r].forbidden.insert(res[d].fixed);
+                if (res[r].fixed >= 0 && res[d].fixed < 0)
+                    res[d].forbidden.insert(res[r].fixed);
+            }
+    }
+
+    return res;
+}
+
+long long T86::RegisterAllocator::allocateFunction(T86Program &program, std::size_t function,
+                                              std::vector<Instruction> &new_code,
+                                              std::vector<std::size_t> &new_place) {
+    auto &code = program.getInstructions();
+    auto &info = program.getFunctions()[function];
+    auto begin = info.begin;
+    auto n = program.functionEnd(function) - begin;
+
+    intervals = analyse(program, function);
+
+    scratch.clear();
+    spill_place.clear();
+    auto registers = floating ? number_of_float_registers : number_of_registers;
+    assignAll(registers);
+    if (assignment.size() < intervals.size()) {
+        // something does not fit -- keep two registers to load the spilled values into
+        if (registers < 3)
+            throw std::invalid_argument("ERROR. At least 3 registers are needed to spill.");
+        if (liveness.argument_registers > registers - 2)
+            throw std::invalid_argument("ERROR. Argument registers overlap the registers for the spilled values.");
+        assignAll(registers - 2);
+        scratch = {registers - 2, registers - 1};
+    }
+
+    Statistics stats;
+    stats.name = floating ? info.name + ":float" : info.name;
+    stats.floating = floating;
+
+    long long spills = 0;
+    for (auto &i: intervals)
+        if (!assignment.count(i.reg)) {
+            if (i.remat)
+                stats.rematerialised++;
+            else {
+                spill_place[i.reg] = -(info.frame_size + ++spills);
+                info.frame_objects.emplace_back(spill_place[i.reg], 1);
+            }
+        }
+    stats.spilled = spills;
+
+    // rewrite the body
+    std::vector<Instruction> body;
+    std::vector<std::size_t> local_place(n);
+    std::set<std::size_t> written;
+
+    // allocation of the frame and its releases (ADD SP before POP BP; RET) by their places in the body
+    auto allocation = program.frameAllocation(function);
+    long long allocation_place = -1;
+    std::set<std::size_t> releases;
+
+    for (std::size_t k = 0; k < n; ++k) {
+        local_place[k] = body.size();
+        position = k;
+        auto &inst = code[begin + k];
+
+        // rematerialised constant is placed directly into its uses
+        auto def = liveness.defs[k];
+        if (def >= 0 && !assignment.count(def) && intervals[def].remat)
+            continue;
+
+        in_scratch.clear();
+        std::vector<Instruction> before, after;
+        rewriteRegister(inst, false, before, after);
+        rewriteRegister(inst, true, before, after);
+
+        // coalesced move
+        if (inst.getOpcode() == Instruction::MOV && !inst.getFirst()->isMemory() &&
+            liveness.registerNumber(inst.getFirst()) >= 0 && *inst.getFirst() == *inst.getSecond()) {
+            stats.coalesced++;
+            continue;
+        }
+
+        for (auto &i: before)
+            body.push_back(std::move(i));
+        if (&inst == allocation)
+            allocation_place = body.size();
+        if (inst.getOpcode() == Instruction::ADD && inst.getFirst()->getNumber() == Register::SP && k + 2 < n &&
+            code[begin + k + 1].getOpcode() == Instruction::POP && code[begin + k + 2].getOpcode() == Instruction::RET)
+            releases.insert(body.size());
+        body.push_back(std::move(inst));
+        for (auto &i: after)
+            body.push_back(std::move(i));
+    }
+
+    // argument registers are saved by the caller
+    for (auto &i: body)
+        if (Instruction::writesFirst(i.getOpcode()) && !i.getFirst()->isMemory())
+            if (auto reg = liveness.registerNumber(i.getFirst()); reg >= (long long) liveness.argument_registers)
+                written.insert(reg);
+
+    // main is called only once and after it program halts -- nothing to save
+    std::vector<std::size_t> saved;
+    if (info.name != "main")
+        saved.assign(written.begin(), written.end());
+
+    // prologue ends by allocation of the frame, or by the MOV BP,SP
+    std::size_t prologue_end = allocation_place >= 0 ? allocation_place : 1;
+
+    auto function_begin = new_code.size();
+    std::vector<std::size_t> final_place(body.size() + 1);
+    for (std::size_t j = 0; j < body.size(); ++j) {
+        final_place[j] = new_code.size();
+
+        if (releases.count(j))
+            for (auto i = saved.rbegin(); i != saved.rend(); ++i)
+                new_code.emplace_back(floating ? Instruction::FPOP : Instruction::POP, makeRegister(*i));
+
+        new_code.push_back(std::move(body[j]));
+
+        if (j == prologue_end) {
+            if (allocation_place < 0 && spills) {
+                info.frame_alloc = true;
+                new_code.emplace_back(Instruction::SUB, Register(Register::SP), IntImmediate());
+            }
+            for (auto i: saved)
+                new_code.emplace_back(floating ? Instruction::FPUSH : Instruction::PUSH, makeRegister(i));
+        }
+    }
+    final_place[body.size()] = new_code.size();
+
+    for (std::size_t k = 0; k < n; ++k)
+        new_place[begin + k] = final_place[local_place[k]];
+
+
+    stats.instructions = new_code.size() - function_begin;
+    // float registers are reported only in the functions, which use them
+    if (!floating || std::any_of(intervals.begin(), intervals.end(), [](Interval &i) { return i.fixed < 0; }))
+        statistics.push_back(stats);
+    return spills;
+}
+
+void T86::RegisterAllocator::assignAll(std::size_t number) {
+    assignment = assign(intervals, number);
+    for (auto &i: intervals)
+        if (i.fixed >= 0)
+            assignment[i.reg] = i.fixed;
+}
+
+void T86::RegisterAllocator::rewriteRegister(Instruction &inst, bool second, std::vector<Instruction> &before,
+                                             std::vector<Instruction> &after) {
+    auto operand = second ? inst.getSecond() : inst.getFirst();
+    if (!operand)
+        return;
+    auto number = liveness.registerNumber(operand);
+    if (number < 0)
+        return;
+    bool mem = operand->isMemory();
+
+    // sets the number of the register of any file (or the one, which holds the address)
+    auto renumber = [operand](std::size_t new_number) {
+        operand->setNumber(new_number);
+    };
+
+    auto virt = liveness.to_dense[number];
+    if (auto phys = assignment.find(virt); phys != assignment.end()) {
+        renumber(phys->second);
+        return;
+    }
+
+    auto &interval = intervals[virt];
+    auto op = inst.getOpcode();
+    if (interval.remat && !mem) {
+        if (second && Instruction::acceptsImmediate(op)) {
+            inst.setSecond(IntImmediate(interval.constant));
+            return;
+        }
+        if (!second && op == Instruction::PUSH) {
+            inst.setFirst(IntImmediate(interval.constant));
+            return;
+        }
+    }
+
+    // value goes through the scratch register
+    bool loaded = in_scratch.count(virt);
+    if (!loaded)
+        in_scratch[virt] = scratch[in_scratch.size()];
+    auto tmp = in_scratch[virt];
+
+    auto &uses = liveness.uses[position];
+    bool used = std::find(uses.begin(), uses.end(), virt) != uses.end();
+    if (!loaded && used) {
+        if (interval.remat)
+            before.emplace_back(Instruction::MOV, Register(tmp), IntImmediate(interval.constant));
+        else
+            before.emplace_back(Instruction::MOV, makeRegister(tmp), Memory(Register(Register::BP, spill_place[virt])));
+    }
+
+    if (!second && !mem && liveness.defs[position] == (long long) virt)
+        after.emplace_back(Instruction::MOV, Memory(Register(Register::BP, spill_place[virt])), makeRegister(tmp));
+
+    renumber(tmp);
+}
+
+T86::Operand T86::RegisterAllocator::makeRegister(std::size_t number) {
+    if (floating)
+        return FRegister(number);
+    return Register(number);
+}
+
+std::map<std::size_t, std::size_t>
+T86::LinearScanAllocator::assign(std::vector<Interval> &intervals, std::size_t number) {
+    std::vector<Interval *> order;
+    for (auto &i: intervals)
+        if (i.fixed < 0)
+            order.emplace_back(&i);
+    std::sort(order.begin(), order.end(), [](Interval *a, Interval *b) {
+        return std::make_pair(a->start, a->reg) < std::make_pair(b->start, b->reg);
+    });
+
+    std::map<std::size_t, std::size_t> res;
+
+    // active intervals sorted by the end
+    std::set<std::pair<std::size_t, std::size_t>> active;
+
+    std::set<std::size_t> free;
+    for (std::size_t i = 0; i < number; ++i)
+        free.insert(i);
+
+    for (auto current: order) {
+        // expire intervals, which are already dead
+        while (!active.empty()) {
+            auto [end, reg] = *active.begin();
+            if (end > current->start || (end == current->start && !current->starts_with_def))
+                break;
+            free.insert(res[reg]);
+            active.erase(active.begin());
+        }
+
+        auto allowed = [current](std::size_t phys) { return !current->forbidden.count(phys); };
+
+        long long hinted = -1;
+        if (current->hint >= 0) {
+            auto &source = intervals[current->hint];
+            if (source.fixed >= 0)
+                hinted = source.fixed;
+            else if (res.count(source.reg))
+                hinted = (long long) res[source.reg];
+        }
+
+        auto first_free = std::find_if(free.begin(), free.end(), allowed);
+
+        std::size_t phys;
+        if (hinted >= 0 && free.count(hinted) && allowed(hinted))
+            // coalesce the move
+            phys = hinted;
+        else if (first_free != free.end())
+            phys = *first_free;
+        else {
+            // spill the rematerialisable interval, or the one, which ends the last
+            auto victim = current;
+            for (auto &[end, reg]: active) {
+                auto candidate = &intervals[reg];
+                if (allowed(res[reg]) &&
+                    std::make_pair(candidate->remat, candidate->end) > std::make_pair(victim->remat, victim->end))
+                    victim = candidate;
+            }
+            if (victim == current)
+                continue;
+
+            phys = res[victim->reg];
+            res.erase(victim->reg);
+            active.erase({victim->end, victim->reg});
+        }
+
+        free.erase(phys);
+        res[current->reg] = phys;
+        active.emplace(current->end, current->reg);
+    }
+
+    return res;
+}
+
+std::map<std::size_t, std::size_t>
+T86::GraphColoringAllocator::assign(std::vector<Interval> &intervals, std::size_t number) {
+    colors = number;
+    build(intervals);
+    makeWorklist();
+
+    while (!simplify_worklist.empty() || !worklist_moves.empty() || !freeze_worklist.empty() ||
+           !spill_worklist.empty()) {
+        if (!simplify_worklist.empty())
+            simplify();
+        else if (!worklist_moves.empty())
+            coalesce();
+        else if (!freeze_worklist.empty())
+            freeze();
+        else
+            selectSpill();
+    }
+
+    return assignColors();
+}
+
+void T86::GraphColoringAllocator::build(std::vector<Interval> &intervals) {
+    auto n = intervals.size();
+    adj_set.clear();
+    adj_list.assign(n, {});
+    degree.assign(n, 0);
+    alias.assign(n, 0);
+    node_state.assign(n, INITIAL);
+    spill_cost.assign(n, 0);
+    forbidden.assign(n, {});
+    preference.assign(n, -1);
+    moves.clear();
+    move_state.clear();
+    move_list.assign(n, {});
+    simplify_worklist.clear();
+    freeze_worklist.clear();
+    spill_worklist.clear();
+    worklist_moves.clear();
+    select_stack.clear();
+
+    auto &uses = liveness.uses;
+    auto &defs = liveness.defs;
+    auto &move_source = liveness.move_source;
+
+    // registers of the calling convention are not in the graph, they only forbid their colours
+    for (std::size_t i = 0; i < n; ++i) {
+        if (intervals[i].fixed >= 0)
+            node_state[i] = PRECOLORED;
+        forbidden[i] = intervals[i].forbidden;
+        degree[i] = forbidden[i].size();
+    }
+
+    for (std::size_t k = 0; k < defs.size(); ++k) {
+        // use inside the loop costs 10 times more, than outside
+        double weight = 1;
+        for (std::size_t i = 0; i < std::min<std::size_t>(liveness.loop_depth[k], 6); ++i)
+            weight *= 10;
+        for (auto r: uses[k])
+            spill_cost[r] += intervals[r].remat ? 0.5 : weight;
+        if (defs[k] >= 0)
+            spill_cost[defs[k]] += intervals[defs[k]].remat ? 0.5 : weight;
+
+        if (defs[k] < 0)
+            continue;
+        auto def = (std::size_t) defs[k];
+
+        // copied value does not interfere with the copy
+        if (move_source[k] >= 0 && (std::size_t) move_source[k] != def) {
+            auto src = (std::size_t) move_source[k];
+            if (intervals[def].fixed >= 0 || intervals[src].fixed >= 0) {
+                // move from/to the argument register -- try to take the same colour
+                if (intervals[def].fixed < 0)
+                    preference[def] = intervals[src].fixed;
+                if (intervals[src].fixed < 0)
+                    preference[src] = intervals[def].fixed;
+            } else {
+                move_list[def].emplace_back(moves.size());
+                move_list[src].emplace_back(moves.size());
+                worklist_moves.insert(moves.size());
+                moves.emplace_back(def, src);
+                move_state.emplace_back(WORKLIST);
+            }
+        }
+
+        for (std::size_t r = 0; r < n; ++r)
+            if (liveness.live_out[k][r] && (long long) r != move_source[k])
+                addEdge(def, r);
+    }
+}
+
+void T86::GraphColoringAllocator::addEdge(std::size_t u, std::size_t v) {
+    if (u == v || adj_set.count({u, v}) || node_state[u] == PRECOLORED || node_state[v] == PRECOLORED)
+        return;
+    adj_set.emplace(u, v);
+    adj_set.emplace(v, u);
+    adj_list[u].insert(v);
+    adj_list[v].insert(u);
+    degree[u]++;
+    degree[v]++;
+}
+
+void T86::GraphColoringAllocator::makeWorklist() {
+    for (std::size_t i = 0; i < node_state.size(); ++i) {
+        if (node_state[i] == PRECOLORED)
+            continue;
+        if (degree[i] >= colors) {
+            node_state[i] = SPILL;
+            spill_worklist.insert(i);
+        } else if (moveRelated(i)) {
+            node_state[i] = FREEZE;
+            freeze_worklist.insert(i);
+        } else {
+            node_state[i] = SIMPLIFY;
+            simplify_worklist.insert(i);
+        }
+    }
+}
+
+std::vector<std::size_t> T86::GraphColoringAllocator::adjacent(std::size_t node) {
+    std::vector<std::size_t> res;
+    for (auto i: adj_list[node])
+        if (node_state[i] != SELECT && node_state[i] != COALESCED)
+            res.emplace_back(i);
+    return res;
+}
+
+std::vector<std::size_t> T86::GraphColoringAllocator::nodeMoves(std::size_t node) {
+    std::vector<std::size_t> res;
+    for (auto i: move_list[node])
+        if (move_state[i] != DONE)
+            res.emplace_back(i);
+    return res;
+}
+
+bool T86::GraphColoringAllocator::moveRelated(std::size_t node) {
+    return !nodeMoves(node).empty();
+}
+
+void T86::GraphColoringAllocator::simplify() {
+    auto node = *simplify_worklist.begin();
+    simplify_worklist.erase(simplify_worklist.begin());
+    node_state[node] = SELECT;
+    select_stack.emplace_back(node);
+    for (auto i: adjacent(node))
+        decrementDegree(i);
+}
+
+void T86::GraphColoringAllocator::decrementDegree(std::size_t node) {
+    if (degree[node]-- != colors || node_state[node] != SPILL)
+        return;
+
+    enableMoves(node);
+    for (auto i: adjacent(node))
+        enableMoves(i);
+
+    spill_worklist.erase(node);
+    if (moveRelated(node)) {
+        node_state[node] = FREEZE;
+        freeze_worklist.insert(node);
+    } else {
+        node_state[node] = SIMPLIFY;
+        simplify_worklist.insert(node);
+    }
+}
+
+void T86::GraphColoringAllocator::enableMoves(std::size_t node) {
+    for (auto i: nodeMoves(node))
+        if (move_state[i] == ACTIVE) {
+            move_state[i] = WORKLIST;
+            worklist_moves.insert(i);
+        }
+}
+
+void T86::GraphColoringAllocator::coalesce() {
+    auto move = *worklist_moves.begin();
+    worklist_moves.erase(worklist_moves.begin());
+
+    auto u = getAlias(moves[move].first);
+    auto v = getAlias(moves[move].second);
+
+    if (u == v) {
+        move_state[move] = DONE;
+        addWorkList(u);
+    } else if (adj_set.count({u, v})) {
+        // constrained -- both are alive at the same time
+        move_state[move] = DONE;
+        addWorkList(u);
+        addWorkList(v);
+    } else if (conservative(u, v)) {
+        move_state[move] = DONE;
+        combine(u, v);
+        addWorkList(u);
+    } else
+        move_state[move] = ACTIVE;
+}
+
+void T86::GraphColoringAllocator::addWorkList(std::size_t node) {
+    if (node_state[node] == FREEZE && !moveRelated(node) && degree[node] < colors) {
+        freeze_worklist.erase(node);
+        node_state[node] = SIMPLIFY;
+        simplify_worklist.insert(node);
+    }
+}
+
+bool T86::GraphColoringAllocator::conservative(std::size_t u, std::size_t v) {
+    std::set<std::size_t> nodes;
+    for (auto i: adjacent(u))
+        nodes.insert(i);
+    for (auto i: adjacent(v))
+        nodes.insert(i);
+
+    std::size_t significant = 0;
+    for (auto i: nodes)
+        if (degree[i] >= colors)
+            significant++;
+    return significant < colors;
+}
+
+std::size_t T86::GraphColoringAllocator::getAlias(std::size_t node) {
+    while (node_state[node] == COALESCED)
+        node = alias[node];
+    return node;
+}
+
+void T86::GraphColoringAllocator::combine(std::size_t u, std::size_t v) {
+    if (node_state[v] == FREEZE)
+        freeze_worklist.erase(v);
+    else
+        spill_worklist.erase(v);
+    node_state[v] = COALESCED;
+    alias[v] = u;
+    spill_cost[u] += spill_cost[v];
+    for (auto i: forbidden[v])
+        if (forbidden[u].insert(i).second)
+            degree[u]++;
+    if (preference[u] < 0)
+        preference[u] = preference[v];
+
+    move_list[u].insert(move_list[u].end(), move_list[v].begin(), move_list[v].end());
+    enableMoves(v);
+
+    for (auto i: adjacent(v)) {
+        addEdge(i, u);
+        decrementDegree(i);
+    }
+
+    if (degree[u] >= colors && node_state[u] == FREEZE) {
+        freeze_worklist.erase(u);
+        node_state[u] = SPILL;
+        spill_worklist.insert(u);
+    }
+}
+
+void T86::GraphColoringAllocator::freeze() {
+    auto node = *freeze_worklist.begin();
+    freeze_worklist.erase(freeze_worklist.begin());
+    node_state[node] = SIMPLIFY;
+    simplify_worklist.insert(node);
+    freezeMoves(node);
+}
+
+void T86::GraphColoringAllocator::freezeMoves(std::size_t node) {
+    for (auto i: nodeMoves(node)) {
+        auto [x, y] = moves[i];
+        auto other = getAlias(y) == getAlias(node) ? getAlias(x) : getAlias(y);
+
+        move_state[i] = DONE;
+        worklist_moves.erase(i);
+
+        if (node_state[other] == FREEZE && !moveRelated(other) && degree[other] < colors) {
+            freeze_worklist.erase(other);
+            node_state[other] = SIMPLIFY;
+            simplify_worklist.insert(other);
+        }
+    }
+}
+
+void T86::GraphColoringAllocator::selectSpill() {
+    // the cheapest one by the cost divided by the degree
+    auto node = *spill_worklist.begin();
+    for (auto i: spill_worklist)
+        if (spill_cost[i] / degree[i] < spill_cost[node] / degree[node])
+            node = i;
+
+    spill_worklist.erase(node);
+    node_state[node] = SIMPLIFY;
+    simplify_worklist.insert(node);
+    freezeMoves(node);
+}
+
+std::map<std::size_t, std::size_t> T86::GraphColoringAllocator::assignColors() {
+    std::map<std::size_t, std::size_t> res;
+
+    while (!select_stack.empty()) {
+        auto node = select_stack.back();
+        select_stack.pop_back();
+
+        std::set<std::size_t> ok_colors;
+        for (std::size_t i = 0; i < colors; ++i)
+            ok_colors.insert(i);
+        for (auto i: adj_list[node])
+            if (auto color = res.find(getAlias(i)); color != res.end())
+                ok_colors.erase(color->second);
+        for (auto i: forbidden[node])
+            ok_colors.erase(i);
+
+        // optimistic -- might be still colourable, even it was marked as the spill candidate
+        if (preference[node] >= 0 && ok_colors.count(preference[node]))
+            res[node] = preference[node];
+        else if (!ok_colors.empty())
+            res[node] = *ok_colors.begin();
+    }
+
+    for (std::size_t i = 0; i < node_state.size(); ++i)
+        if (node_state[i] == COALESCED)
+            if (auto color = res.find(getAlias(i)); color != res.end())
+                res[i] = color->second;
+
+    return res;
+}
@@ -1,34 +1,150 @@
 #include "T86Inst.h"
 
+#include <stdexcept>
+#include <algorithm>
 
-T86::Instruction::Instruction(Opcode new_op, std::unique_ptr<Operand> &&new_l,
-                              std::unique_ptr<Operand> &&new_r) {
-    op = new_op;
-    if (new_l)
-        first = std::move(new_l);
-    if (new_r)
-        second = std::move(new_r);
-}
 
-void T86::Instruction::addOperand(std::unique_ptr<Operand> &&new_operand) {
-    if (!first) {
-        first = std::move(new_operand);
+T86::Instruction::Instruction(Opcode new_op, const Operand &new_l, const Operand &new_r)
+        : op(new_op), first(new_l), second(new_r) {}
+
+void T86::Instruction::addOperand(const Operand &new_operand) {
+    if (first.getKind() == Operand::NONE) {
+        first = new_operand;
         return;
     }
 
-    second = std::move(new_operand);
+    second = new_operand;
 }
 
 T86::Instruction::Opcode T86::Instruction::getOpcode() {
     return op;
 }
 
-void T86::Instruction::print(std::ostream &oss) {
-    oss << opcode_to_str.find(op)->second << ' ';
-    if (first)
-        oss << first->toString();
-    if (second)
-        oss << ',' << second->toString();
+T86::Operand *T86::Instruction::getFirst() {
+    return first.getKind() == Operand::NONE ? nullptr : &first;
+}
+
+T86::Operand *T86::Instruction::getSecond() {
+    return second.getKind() == Operand::NONE ? nullptr : &second;
+}
+
+void T86::Instruction::setFirst(const Operand &new_operand) {
+    first = new_operand;
+}
+
+void T86::Instruction::setSecond(const Operand &new_operand) {
+    second = new_operand;
+}
+
+bool T86::Instruction::isBranch(Opcode opcode) {
+    return (opcode >= JMP && opcode <= JNS) || opcode == CALL;
+}
+
+bool T86::Instruction::isTerminator(Opcode opcode) {
+    return opcode == JMP || opcode == RET || opcode == HALT;
+}
+
+bool T86::Instruction::readsFirst(Opcode opcode) {
+    switch (opcode) {
+        case MOV:
+        case LEA:
+        case POP:
+        case FPOP:
+        case GETCHAR:
+        case EXT:
+        case NRW:
+            return false;
+        default:
+            return !isBranch(opcode);
+    }
+}
+
+bool T86::Instruction::writesFirst(Opcode opcode) {
+    switch (opcode) {
+        case MOV:
+        case LEA:
+        case ADD:
+        case SUB:
+        case INC:
+        case DEC:
+        case NEG:
+        case MUL:
+        case DIV:
+        case IMUL:
+        case IDIV:
+        case FADD:
+        case FSUB:
+        case FMUL:
+        case FDIV:
+        case AND:
+        case OR:
+        case XOR:
+        case LSH:
+        case RSH:
+        case POP:
+        case FPOP:
+        case GETCHAR:
+        case EXT:
+        case NRW:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void T86::Instruction::print(Writer &out) {
+    out << opcode_to_str[op] << ' ';
+    if (first.getKind() != Operand::NONE)
+        first.print(out);
+    if (second.getKind() != Operand::NONE) {
+        out << ',';
+        second.print(out);
+    }
+}
+
+bool T86::Instruction::acceptsImmediate(Opcode opcode) {
+    switch (opcode) {
+        case MOV:
+        case ADD:
+        case SUB:
+        case MUL:
+        case DIV:
+        case IMUL:
+        case IDIV:
+        case AND:
+        case OR:
+        case XOR:
+        case LSH:
+        case RSH:
+        case CMP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool T86::Instruction::isConditional(Opcode opcode) {
+    return opcode >= JZ && opcode <= JNS;
+}
+
+T86::Instruction::Opcode T86::Instruction::invertCondition(Opcode opcode) {
+    static const std::map<Opcode, Opcode> opposite = {
+            {JZ,  JNZ},
+            {JE,  JNE},
+            {JG,  JLE},
+            {JGE, JL},
+            {JA,  JBE},
+            {JAE, JB},
+            {JO,  JNO},
+            {JS,  JNS}
+    };
+    for (auto &[a, b]: opposite) {
+        if (a == opcode)
+            return b;
+        if (b == opcode)
+            return a;
+    }
+    throw std::invalid_argument("ERROR. Instruction is not a conditional jump.");
 }
 
 T86::Instruction *T86::T86Program::emplaceInstruction(Instruction &&inst) {
@@ -36,26 +152,167 @@ T86::Instruction *T86::T86Program::emplaceInstruction(Instruction &&inst) {
     return &program.back();
 }
 
-void T86::T86Program::print(std::ostream &oss) {
-    oss << ".text" << std::endl;
+void T86::T86Program::print(Writer &out) {
+    if (!data.empty()) {
+        out << ".data\n";
+        for (auto &i: data) {
+            i.print(out);
+            out << '\n';
+        }
+    }
+
+    out << ".text\n";
     for (size_t i = 0; i < program.size(); ++i) {
-        oss << std::to_string(i) << ' ';
-        program[i].print(oss);
-        oss << std::endl;
+        out << i << ' ';
+        program[i].print(out);
+        out << '\n';
+    }
+}
+
+std::vector<T86::Instruction> &T86::T86Program::getInstructions() {
+    return program;
+}
+
+void T86::T86Program::addFunction(std::string name) {
+    functions.emplace_back();
+    functions.back().name = name;
+    functions.back().begin = program.size();
+}
+
+std::vector<T86::FunctionInfo> &T86::T86Program::getFunctions() {
+    return functions;
+}
+
+std::size_t T86::T86Program::functionEnd(std::size_t order) {
+    if (order + 1 < functions.size())
+        return functions[order + 1].begin;
+    return program.size();
+}
+
+void T86::T86Program::relocate(std::vector<Instruction> &&new_program, const std::vector<std::size_t> &new_place) {
+    program = std::move(new_program);
+
+    for (auto &i: program)
+        if (Instruction::isBranch(i.getOpcode()))
+            if (auto target = i.getFirst(); target && target->isIntImmediate())
+                if (target->getValue() >= 0 && target->getValue() < (long long) new_place.size())
+                    target->addValue(new_place[target->getValue()]);
+
+    for (auto &i: functions)
+        i.begin = new_place[i.begin];
+}
+
+T86::Instruction *T86::T86Program::frameAllocation(std::size_t function) {
+    auto place = functions[function].begin + 2;
+    if (!functions[function].frame_alloc || place >= functionEnd(function))
+        return nullptr;
+
+    // passes might remove the allocation
+    auto &inst = program[place];
+    if (inst.getOpcode() != Instruction::SUB || !inst.getFirst()->isRegister() ||
+        inst.getFirst()->getNumber() != Register::SP || !inst.getSecond() || !inst.getSecond()->isIntImmediate())
+        return nullptr;
+    return &inst;
+}
+
+void T86::T86Program::setFrameSize(std::size_t function, long long new_size) {
+    functions[function].frame_size = new_size;
+    if (auto allocation = frameAllocation(function))
+        allocation->getSecond()->addValue(new_size);
+
+    // ADD SP,n; POP BP; RET
+    for (auto k = functions[function].begin + 2; k < functionEnd(function); ++k) {
+        if (program[k].getOpcode() != Instruction::RET)
+            continue;
+        auto &release = program[k - 2];
+        if (release.getOpcode() == Instruction::ADD && release.getFirst()->isRegister() &&
+            release.getFirst()->getNumber() == Register::SP && release.getSecond()->isIntImmediate())
+            release.getSecond()->addValue(new_size);
     }
 }
 
+T86::CallingConvention &T86::T86Program::getCallingConvention() {
+    return convention;
+}
+
+T86::FunctionInfo *T86::T86Program::functionAt(long long place) {
+    if (place < 0)
+        return -1 - place < (long long) externals.size() ? &externals[-1 - place] : nullptr;
+    for (auto &i: functions)
+        if ((long long) i.begin == place)
+            return &i;
+    return nullptr;
+}
+
+long long T86::T86Program::addData(const std::vector<Operand> &words) {
+    auto address = (long long) data.size();
+    data.insert(data.end(), words.begin(), words.end());
+    return address;
+}
+
+const std::vector<T86::Operand> &T86::T86Program::getData() {
+    return data;
+}
+
+long long T86::T86Program::addExternal(const std::string &name) {
+    for (std::size_t i = 0; i < externals.size(); ++i)
+        if (externals[i].name == name)
+            return (long long) i;
+    externals.emplace_back();
+    externals.back().name = name;
+    externals.back().register_arguments = convention.registers;
+    externals.back().float_register_arguments = convention.float_registers;
+    return (long long) externals.size() - 1;
+}
+
+std::vector<T86::FunctionInfo> &T86::T86Program::getExternals() {
+    return externals;
+}
+
+void T86::T86Program::append(T86Program &&other) {
+    auto base = (long long) program.size();
+    for (auto &i: other.program) {
+        if (Instruction::isBranch(i.getOpcode()))
+            if (auto target = i.getFirst(); target && target->isIntImmediate())
+                target->addValue(target->getValue() >= 0 ? target->getValue() + base
+                                                         : -1 - addExternal(other.externals[-1 - target->getValue()].name));
+        program.push_back(std::move(i));
+    }
+
+    for (auto &i: other.functions) {
+        functions.push_back(std::move(i));
+        functions.back().begin += base;
+    }
+}
+
+void T86::T86Program::linkExternals() {
+    std::map<std::string, std::size_t> addresses;
+    for (auto &i: functions)
+        addresses.emplace(i.name, i.begin);
+
+    for (auto &i: program)
+        if (i.getOpcode() == Instruction::CALL)
+            if (auto target = i.getFirst(); target && target->isIntImmediate() && target->getValue() < 0) {
+                auto address = addresses.find(externals[-1 - target->getValue()].name);
+                if (address != addresses.end())
+                    target->addValue((long long) address->second);
+            }
+}
+
+std::size_t T86::CallingConvention::reserved() {
+    return std::max(registers, float_registers);
+}
 
 void T86::MemorySpace::addOperand(unsigned long long value){
-    register_space[value] = std::make_unique<T86::Register>(value);
+    register_space[value] = T86::Register(value);
 }
 
-void T86::MemorySpace::addOperand(unsigned long long, std::unique_ptr<T86::Memory>){
+void T86::MemorySpace::addOperand(unsigned long long, const Memory &){
 
 }
 
-std::unique_ptr<T86::Operand> T86::MemorySpace::getOperand(unsigned long long value){
-    return register_space[value]->clone();
+T86::Operand T86::MemorySpace::getOperand(unsigned long long value){
+    return register_space[value];
 }
 
 
@@ -76,7 +333,7 @@ long long T86::Context::getCurrentPlaceOnStack(long long offset){
     return res;
 }
 
-std::unique_ptr<T86::Operand> T86::Context::getOperand(unsigned long long val) {
+T86::Operand T86::Context::getOperand(unsigned long long val) {
     return mem_allocator.getOperand(val);
 }
 
@@ -85,37 +342,122 @@ void T86::Context::addInstruction(T86::Instruction &&new_instruction) {
     //program.emplaceInstruction(T86::Instruction(T86::Instruction::NOP));
 }
 
-void T86::Context::print(std::ostream& oss) {
-    program.print(oss);
+long long T86::Context::addData(const std::vector<Operand> &words) {
+    return program.addData(words);
+}
+
+void T86::Context::print(Writer &out) {
+    program.print(out);
 }
 
 std::size_t T86::Context::getNumberOfInstructions() {
     return program.getNumberOfInstructions();
 }
 
-void T86::Context::addFunctionCall(std::string name, IntImmediate *place_to_call) {
-    notFinishedCalls[name].emplace_back(place_to_call);
+void T86::Context::addFunctionCall(std::string name) {
+    notFinishedCalls[name].emplace_back(program.getNumberOfInstructions());
 }
 
 void T86::Context::addFunctionPlace(std::string name) {
     placeForCall.emplace(name, program.getNumberOfInstructions());
+    program.addFunction(name);
 }
 
-void T86::Context::addJumpToLabel(long long label_number, IntImmediate *place_to_jump) {
-    notFinishedJumps[label_number].emplace_back(place_to_jump);
+void T86::Context::addJumpToLabel(long long label_number) {
+    notFinishedJumps[label_number].emplace_back(program.getNumberOfInstructions());
 }
 
 void T86::Context::addLabelPlace(long long label_number) {
     placeForJumps.emplace(label_number, program.getNumberOfInstructions());
 }
 
+void T86::Context::addReturningFunction(std::string name) {
+    returningFunctions.insert(name);
+}
+
+bool T86::Context::doesFunctionReturn(std::string name) {
+    return returningFunctions.count(name);
+}
+
+void T86::Context::addFrameAllocation(long long size) {
+    program.getFunctions().back().frame_size = size;
+    program.getFunctions().back().frame_alloc = size != 0;
+}
+
+void T86::Context::addFrameObject(long long place, long long size) {
+    program.getFunctions().back().frame_objects.emplace_back(place, size);
+}
+
+T86::T86Program &T86::Context::getProgram() {
+    return program;
+}
+
+T86::FunctionInfo &T86::Context::currentFunction() {
+    return program.getFunctions().back();
+}
+
 void T86::Context::finishCallsAndJmps() {
-    for (auto &[i, j]: placeForCall)
-        for (auto &place: notFinishedCalls[i])
-            place->addValue(j);
+    auto &code = program.getInstructions();
+    std::set<std::string> defined;
+    for (auto &[i, j]: placeForCall) {
+        defined.insert(i);
+        for (auto place: notFinishedCalls[i])
+            code[place].setFirst(IntImmediate(j));
+    }
+
+    // the function is in the other part of the program
+    for (auto &[i, j]: notFinishedCalls)
+        if (!defined.count(i))
+            for (auto place: j)
+                code[place].setFirst(IntImmediate(-1 - program.addExternal(i)));
 
     for (auto &[i, j]: placeForJumps)
-        for (auto &place: notFinishedJumps[i])
-            place->addValue(j);
+        for (auto place: notFinishedJumps[i])
+            code[place].setFirst(IntImmediate(j));
+
+    removeFallthroughJumps();
+}
+
+void T86::Context::removeFallthroughJumps() {
+    auto &code = program.getInstructions();
+    auto target = [&code](std::size_t k) {
+        auto place = code[k].getFirst();
+        return place && place->isIntImmediate() ? place->getValue() : -1;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
 
+        std::vector<bool> is_target(code.size() + 1);
+        for (std::size_t k = 0; k < code.size(); ++k)
+            if (Instruction::isBranch(code[k].getOpcode()) && target(k) >= 0 &&
+                target(k) <= (long long) code.size())
+                is_target[target(k)] = true;
+
+        std::vector<Instruction> new_code;
+        std::vector<std::size_t> new_place(code.size() + 1);
+        for (std::size_t k = 0; k < code.size(); ++k) {
+            new_place[k] = new_code.size();
+            auto op = code[k].getOpcode();
+
+            if (op == Instruction::JMP && target(k) == (long long) k + 1) {
+                changed = true;
+                continue;
+            }
+
+            if (Instruction::isConditional(op) && k + 1 < code.size() && !is_target[k + 1] &&
+                code[k + 1].getOpcode() == Instruction::JMP && target(k) == (long long) k + 2) {
+                new_code.emplace_back(Instruction::invertCondition(op), IntImmediate(target(k + 1)));
+                new_place[++k] = new_code.size();
+                changed = true;
+                continue;
+            }
+
+            new_code.push_back(std::move(code[k]));
+        }
+        new_place[code.size()] = new_code.size();
+
+        program.relocate(std::move(new_code), new_place);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef COMPILER_HASH_H
+#define COMPILER_HASH_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * 64-bit FNV-1a hash, which is fed by the values one after another
+ */
+class Hash {
+public:
+    Hash &add(std::string_view);
+
+    Hash &add(std::uint64_t);
+
+    std::uint64_t value() const;
+
+    // value as 16 hexadecimal digits
+    std::string toString() const;
+
+private:
+    void addByte(unsigned char);
+
+    std::uint64_t state = 14695981039346656037ULL;
+};
+
+#endif //COMPILER_HASH_H
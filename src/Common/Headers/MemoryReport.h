@@ -0,0 +1,88 @@
+#ifndef COMPILER_MEMORYREPORT_H
+#define COMPILER_MEMORYREPORT_H
+
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+#include <vector>
+
+/**
+ * Memory of the compilation. Nodes of the AST, types and IR values are allocated by the hooks of their base
+ * classes, which register the objects created on the thread of the active report. Snapshot after the phase
+ * groups the live objects by their classes (bytes are the sizes of the objects themselves, without their
+ * strings and vectors) and adds the code of T86 and the peak resident memory of the process
+ */
+class MemoryReport {
+public:
+    enum Kind {
+        AST,
+        TYPE,
+        IR,
+        KINDS
+    };
+
+    // the report is active on this thread, while it exists
+    MemoryReport();
+
+    MemoryReport(const MemoryReport &) = delete;
+
+    MemoryReport &operator=(const MemoryReport &) = delete;
+
+    ~MemoryReport();
+
+    // operator new of the base class
+    template<typename Base>
+    static void *allocate(std::size_t size, Kind kind) {
+        auto object = ::operator new(size);
+        if (active)
+            active->add(object, size, kind, [](void *i) -> const std::type_info & {
+                return typeid(*static_cast<Base *>(i));
+            });
+        return object;
+    }
+
+    // operator delete of the base class
+    static void release(void *);
+
+    // live objects after the phase with the code of T86 (instructions, their operands and bytes). Phase,
+    // which repeats (for each function), keeps the biggest values
+    void snapshot(std::string_view, std::size_t = 0, std::size_t = 0, std::size_t = 0);
+
+    void printReport(std::ostream &);
+
+private:
+    using TypeOf = const std::type_info &(*)(void *);
+
+    struct Counter {
+        std::size_t count = 0, bytes = 0;
+    };
+
+    struct Row {
+        std::string phase;
+
+        Counter kinds[KINDS];
+
+        Counter instructions;
+
+        std::size_t operands = 0;
+
+        // kilobytes
+        long peak = 0;
+    };
+
+    void add(void *, std::size_t, Kind, TypeOf);
+
+    static thread_local MemoryReport *active;
+
+    MemoryReport *previous;
+
+    std::vector<Row> rows;
+
+    // the biggest number of the live objects of each class over the snapshots
+    std::map<std::string, Counter> classes[KINDS];
+};
+
+#endif //COMPILER_MEMORYREPORT_H
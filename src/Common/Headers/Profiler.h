@@ -0,0 +1,136 @@
+#ifndef COMPILER_PROFILER_H
+#define COMPILER_PROFILER_H
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * Nested timers of the phases of the compiler. Phase measures the wall time and the CPU time of its thread
+ * and belongs to the phase, which is open on the same thread, when it starts. Times of the phases with the
+ * same name under the same parent are added up. Spans of the functions go only into the trace, which is
+ * written in the trace event format of Chrome (chrome://tracing or Perfetto can open it)
+ */
+class Profiler {
+public:
+    struct Node;
+
+    // does it collect the events for the trace
+    explicit Profiler(bool);
+
+    ~Profiler();
+
+    /**
+     * Phase, which is measured while the object exists. Nothing is measured without the profiler
+     */
+    class Phase {
+    public:
+        Phase(Profiler *, std::string_view);
+
+        Phase(const Phase &) = delete;
+
+        Phase &operator=(const Phase &) = delete;
+
+        ~Phase();
+
+    private:
+        Profiler *profiler;
+
+        Node *node = nullptr;
+
+        std::chrono::steady_clock::time_point wall;
+
+        double cpu = 0;
+    };
+
+    /**
+     * Span of a single function inside of the phase. Goes only into the trace
+     */
+    class Span {
+    public:
+        Span(Profiler *, std::string_view);
+
+        Span(const Span &) = delete;
+
+        Span &operator=(const Span &) = delete;
+
+        ~Span();
+
+    private:
+        Profiler *profiler;
+
+        std::string name;
+
+        std::chrono::steady_clock::time_point wall;
+    };
+
+    /**
+     * Phases of the other thread belong to the phase of this thread, while the object exists
+     */
+    class Attach {
+    public:
+        Attach(Profiler *, Node *);
+
+        Attach(const Attach &) = delete;
+
+        Attach &operator=(const Attach &) = delete;
+
+        ~Attach();
+
+    private:
+        Profiler *profiler;
+    };
+
+    // phase, which is open on this thread (nullptr -- none)
+    Node *current();
+
+    // adds the time measured outside of the phases as the phase inside of the current one
+    void add(std::string_view, double, double);
+
+    // prints the wall and the CPU time of each phase in milliseconds
+    void printReport(std::ostream &);
+
+    void writeTrace(const std::string &);
+
+    // CPU time of this thread in milliseconds
+    static double threadTime();
+
+private:
+    Node *enter(std::string_view);
+
+    void leave(Node *, std::string_view, const char *, std::chrono::steady_clock::time_point, double);
+
+    void print(std::ostream &, const Node &, std::size_t);
+
+    struct Event {
+        std::string name;
+
+        const char *category;
+
+        double start, duration;
+
+        std::size_t thread;
+    };
+
+    bool trace;
+
+    std::mutex lock;
+
+    // phases without a parent
+    std::unique_ptr<Node> root;
+
+    std::vector<Event> events;
+
+    // threads are numbered in the trace by their first event
+    std::map<std::thread::id, std::size_t> threads;
+
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif //COMPILER_PROFILER_H
@@ -0,0 +1,41 @@
+#ifndef COMPILER_SCHEDULER_H
+#define COMPILER_SCHEDULER_H
+
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Work-stealing scheduler of the independent tasks. Tasks are dealt into the queues of the workers.
+ * Each worker takes the tasks from the back of its own queue and, when it is empty, steals from the
+ * front of the queues of the others. Results have to be kept by the tasks, so they do not depend on the
+ * order, in which the tasks have run
+ */
+class Scheduler {
+public:
+    explicit Scheduler(std::size_t);
+
+    // runs all the tasks and waits for them. Exception of the first failed task (by the order) is thrown again
+    void run(const std::vector<std::function<void()>> &);
+
+private:
+    struct Queue {
+        std::mutex lock;
+
+        std::deque<std::size_t> tasks;
+    };
+
+    // next task of the worker, false if there is none in any queue
+    bool take(std::size_t, std::size_t &);
+
+    void work(std::size_t, const std::vector<std::function<void()>> &, std::vector<std::exception_ptr> &);
+
+    std::size_t threads;
+
+    std::vector<std::unique_ptr<Queue>> queues;
+};
+
+#endif //COMPILER_SCHEDULER_H
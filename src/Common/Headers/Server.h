@@ -0,0 +1,53 @@
+#ifndef COMPILER_SERVER_H
+#define COMPILER_SERVER_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+/**
+ * Compile server on the Unix domain socket. Request is the working directory of the client and its command
+ * line. Requests are run by the fixed number of the workers, the rest waits in the queue of the bounded
+ * size. Answer is the console output of the request followed by the single byte with its exit status
+ */
+class Server {
+public:
+    // runs the command line from the directory and writes the console output into the descriptor.
+    // Returns the exit status
+    using Handler = std::function<int(const std::vector<std::string> &, const std::string &, int)>;
+
+    Server(const std::string &, std::size_t, Handler);
+
+    ~Server();
+
+    // accepts the requests until SIGINT or SIGTERM comes, then finishes the accepted ones
+    void run();
+
+    // sends the command line to the server at the socket and prints the answer. Returns the exit status
+    static int request(const std::string &, const std::vector<std::string> &);
+
+private:
+    void work();
+
+    void serve(int);
+
+    std::string path;
+
+    std::size_t workers;
+
+    Handler handler;
+
+    int listener = -1;
+
+    std::mutex lock;
+
+    std::condition_variable ready, space;
+
+    // accepted connections, which wait for a worker
+    std::queue<int> connections;
+};
+
+#endif //COMPILER_SERVER_H
@@ -0,0 +1,73 @@
+#ifndef COMPILER_WRITER_H
+#define COMPILER_WRITER_H
+
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Buffered output into a file (or into the standard output). Text is formatted right into the buffer,
+ * which goes out by a single write, when it is full, and at the end. Works as the std::streambuf too, so
+ * the printers over std::ostream use the same buffer. Line ends do not flush it
+ */
+class Writer : public std::streambuf {
+public:
+    // writes into the descriptor, which stays open
+    explicit Writer(int);
+
+    // creates (or truncates) the file
+    explicit Writer(const std::string &);
+
+    Writer(const Writer &) = delete;
+
+    Writer &operator=(const Writer &) = delete;
+
+    ~Writer() override;
+
+    Writer &operator<<(char);
+
+    Writer &operator<<(std::string_view);
+
+    Writer &operator<<(long long);
+
+    Writer &operator<<(std::size_t);
+
+    // as std::to_string: fixed with 6 digits after the point
+    Writer &operator<<(double);
+
+    // writes everything from the buffer out
+    void flush();
+
+    // number of the characters written so far
+    std::size_t position() const;
+
+    // overwrites the text at the position. Text, which is already out, can be rewritten only in a file
+    void patch(std::size_t, std::string_view);
+
+protected:
+    int_type overflow(int_type) override;
+
+    std::streamsize xsputn(const char *, std::streamsize) override;
+
+private:
+    void append(const char *, std::size_t);
+
+    // makes sure there is a place for the number in the buffer
+    char *reserve(std::size_t);
+
+    static constexpr std::size_t capacity = 1 << 16;
+
+    int descriptor;
+
+    bool owned = false;
+
+    std::vector<char> buffer;
+
+    std::size_t used = 0;
+
+    // characters, which went out from the buffer
+    std::size_t flushed = 0;
+};
+
+#endif //COMPILER_WRITER_H
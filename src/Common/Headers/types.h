@@ -5,12 +5,16 @@
 #include <vector>
 #include <string>
 
+#include "MemoryReport.h"
 
 /**
  * Abstract class of the inner class system
  */
 class Type {
 public:
+    static void *operator new(std::size_t size) { return MemoryReport::allocate<Type>(size, MemoryReport::TYPE); }
+
+    static void operator delete(void *object) { MemoryReport::release(object); }
 
     // checks, could convert other to "this" Type
     // uses in a typechecker, confirming that it is possible to use the operations
@@ -36,6 +40,8 @@ public:
 
     bool canConvertToThisType(const Type *other) const override;
 
+    int getBits() const;
+
     std::string toString() override;
 
     long long size() override;
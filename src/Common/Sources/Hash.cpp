@@ -0,0 +1,32 @@
+#include "Hash.h"
+
+Hash &Hash::add(std::string_view text) {
+    // length keeps the neighbouring strings apart
+    add((std::uint64_t) text.size());
+    for (auto i: text)
+        addByte((unsigned char) i);
+    return *this;
+}
+
+Hash &Hash::add(std::uint64_t number) {
+    for (int i = 0; i < 8; ++i)
+        addByte((unsigned char) (number >> (8 * i)));
+    return *this;
+}
+
+std::uint64_t Hash::value() const {
+    return state;
+}
+
+std::string Hash::toString() const {
+    static const char digits[] = "0123456789abcdef";
+    std::string res(16, '0');
+    for (int i = 0; i < 16; ++i)
+        res[15 - i] = digits[(state >> (4 * i)) & 15];
+    return res;
+}
+
+void Hash::addByte(unsigned char byte) {
+    state ^= byte;
+    state *= 1099511628211ULL;
+}
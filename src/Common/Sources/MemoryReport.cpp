@@ -0,0 +1,130 @@
+#include "MemoryReport.h"
+
+#include <algorithm>
+#include <cxxabi.h>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <sys/resource.h>
+
+namespace {
+    struct Object {
+        MemoryReport *owner;
+
+        std::size_t size;
+
+        MemoryReport::Kind kind;
+
+        const std::type_info &(*type)(void *);
+    };
+
+    // objects of all the reports. The object may be freed by any thread, so it is found by its address
+    std::mutex lock;
+
+    std::unordered_map<void *, Object> objects;
+
+    // freeing does not look into the map, while it is empty
+    std::atomic<std::size_t> registered = 0;
+
+    std::string className(const std::type_info &type) {
+        int status = 0;
+        std::unique_ptr<char, void (*)(void *)> name(abi::__cxa_demangle(type.name(), nullptr, nullptr, &status),
+                                                     std::free);
+        return status == 0 && name ? name.get() : type.name();
+    }
+}
+
+thread_local MemoryReport *MemoryReport::active = nullptr;
+
+MemoryReport::MemoryReport() : previous(active) {
+    active = this;
+}
+
+MemoryReport::~MemoryReport() {
+    active = previous;
+
+    // objects, which live longer, are not counted any more
+    std::lock_guard guard(lock);
+    std::erase_if(objects, [this](auto &i) { return i.second.owner == this; });
+    registered = objects.size();
+}
+
+void MemoryReport::release(void *object) {
+    if (registered.load(std::memory_order_relaxed)) {
+        std::lock_guard guard(lock);
+        if (objects.erase(object))
+            registered = objects.size();
+    }
+    ::operator delete(object);
+}
+
+void MemoryReport::add(void *object, std::size_t size, Kind kind, TypeOf type) {
+    std::lock_guard guard(lock);
+    objects[object] = {this, size, kind, type};
+    registered = objects.size();
+}
+
+void MemoryReport::snapshot(std::string_view phase, std::size_t instructions, std::size_t operands,
+                            std::size_t bytes) {
+    Row now;
+    std::map<std::string, Counter> live[KINDS];
+    {
+        std::lock_guard guard(lock);
+        for (auto &[object, info]: objects) {
+            if (info.owner != this)
+                continue;
+            auto &counter = live[info.kind][className(info.type(object))];
+            ++counter.count;
+            counter.bytes += info.size;
+            ++now.kinds[info.kind].count;
+            now.kinds[info.kind].bytes += info.size;
+        }
+    }
+    now.instructions = {instructions, bytes};
+    now.operands = operands;
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    now.peak = usage.ru_maxrss;
+
+    for (std::size_t kind = 0; kind < KINDS; ++kind)
+        for (auto &[name, counter]: live[kind]) {
+            auto &peak = classes[kind][name];
+            if (counter.bytes > peak.bytes)
+                peak = counter;
+        }
+
+    auto row = std::find_if(rows.begin(), rows.end(), [&](auto &i) { return i.phase == phase; });
+    if (row == rows.end()) {
+        now.phase = phase;
+        rows.emplace_back(std::move(now));
+        return;
+    }
+    for (std::size_t kind = 0; kind < KINDS; ++kind)
+        if (now.kinds[kind].bytes > row->kinds[kind].bytes)
+            row->kinds[kind] = now.kinds[kind];
+    if (now.instructions.bytes > row->instructions.bytes) {
+        row->instructions = now.instructions;
+        row->operands = now.operands;
+    }
+    row->peak = std::max(row->peak, now.peak);
+}
+
+void MemoryReport::printReport(std::ostream &oss) {
+    oss << "phase ast ast-bytes types type-bytes ir ir-bytes instructions operands code-bytes peak-kb" << std::endl;
+    for (auto &i: rows) {
+        oss << i.phase;
+        for (auto &kind: i.kinds)
+            oss << ' ' << kind.count << ' ' << kind.bytes;
+        oss << ' ' << i.instructions.count << ' ' << i.operands << ' ' << i.instructions.bytes << ' ' << i.peak
+            << std::endl;
+    }
+
+    // classes by their peaks
+    oss << "class count bytes" << std::endl;
+    for (auto &kind: classes) {
+        std::vector<std::pair<std::string, Counter>> sorted(kind.begin(), kind.end());
+        std::stable_sort(sorted.begin(), sorted.end(), [](auto &a, auto &b) { return a.second.bytes > b.second.bytes; });
+        for (auto &[name, counter]: sorted)
+            oss << name << ' ' << counter.count << ' ' << counter.bytes << std::endl;
+    }
+}
@@ -0,0 +1,183 @@
+#include "Profiler.h"
+
+#include <iomanip>
+#include <time.h>
+
+#include "Writer.h"
+
+struct Profiler::Node {
+    std::string name;
+
+    Node *parent = nullptr;
+
+    std::vector<std::unique_ptr<Node>> children;
+
+    double wall = 0, cpu = 0;
+};
+
+// open phases of the thread, the innermost is the last. Profilers of the different compilations may share
+// the thread one after another, so each phase knows its profiler
+static thread_local std::vector<std::pair<Profiler *, Profiler::Node *>> open;
+
+static double since(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+Profiler::Profiler(bool new_trace)
+        : trace(new_trace), root(std::make_unique<Node>()),
+          start(std::chrono::steady_clock::now()) {}
+
+Profiler::~Profiler() = default;
+
+Profiler::Phase::Phase(Profiler *new_profiler, std::string_view name) : profiler(new_profiler) {
+    if (!profiler)
+        return;
+    node = profiler->enter(name);
+    // wall time covers the CPU time
+    wall = std::chrono::steady_clock::now();
+    cpu = threadTime();
+}
+
+Profiler::Phase::~Phase() {
+    if (!profiler)
+        return;
+    profiler->leave(node, node->name, "phase", wall, threadTime() - cpu);
+}
+
+Profiler::Span::Span(Profiler *new_profiler, std::string_view new_name)
+        : profiler(new_profiler && new_profiler->trace ? new_profiler : nullptr) {
+    if (!profiler)
+        return;
+    name = new_name;
+    wall = std::chrono::steady_clock::now();
+}
+
+Profiler::Span::~Span() {
+    if (!profiler)
+        return;
+    profiler->leave(nullptr, name, "function", wall, 0);
+}
+
+Profiler::Attach::Attach(Profiler *new_profiler, Node *node) : profiler(new_profiler) {
+    if (profiler)
+        open.emplace_back(profiler, node);
+}
+
+Profiler::Attach::~Attach() {
+    if (profiler)
+        open.pop_back();
+}
+
+Profiler::Node *Profiler::current() {
+    for (auto i = open.rbegin(); i != open.rend(); ++i)
+        if (i->first == this)
+            return i->second;
+    return nullptr;
+}
+
+void Profiler::add(std::string_view name, double wall, double cpu) {
+    auto parent = current();
+    std::lock_guard guard(lock);
+    if (!parent)
+        parent = root.get();
+    for (auto &i: parent->children)
+        if (i->name == name) {
+            i->wall += wall;
+            i->cpu += cpu;
+            return;
+        }
+    auto &node = parent->children.emplace_back(std::make_unique<Node>());
+    node->name = name;
+    node->parent = parent;
+    node->wall = wall;
+    node->cpu = cpu;
+}
+
+Profiler::Node *Profiler::enter(std::string_view name) {
+    auto parent = current();
+    Node *res = nullptr;
+    {
+        std::lock_guard guard(lock);
+        if (!parent)
+            parent = root.get();
+        for (auto &i: parent->children)
+            if (i->name == name)
+                res = i.get();
+        if (!res) {
+            res = parent->children.emplace_back(std::make_unique<Node>()).get();
+            res->name = name;
+            res->parent = parent;
+        }
+    }
+    open.emplace_back(this, res);
+    return res;
+}
+
+void Profiler::leave(Node *node, std::string_view name, const char *category,
+                     std::chrono::steady_clock::time_point begin, double cpu) {
+    auto end = std::chrono::steady_clock::now();
+    if (node)
+        open.pop_back();
+
+    std::lock_guard guard(lock);
+    if (node) {
+        node->wall += since(begin, end);
+        node->cpu += cpu;
+    }
+    if (trace) {
+        auto thread = threads.emplace(std::this_thread::get_id(), threads.size()).first->second;
+        events.push_back({std::string(name), category, since(start, begin) * 1000, since(begin, end) * 1000, thread});
+    }
+}
+
+void Profiler::printReport(std::ostream &oss) {
+    std::lock_guard guard(lock);
+    double wall = 0, cpu = 0;
+    for (auto &i: root->children) {
+        wall += i->wall;
+        cpu += i->cpu;
+    }
+
+    auto flags = oss.flags();
+    auto precision = oss.precision();
+    oss << std::fixed << std::setprecision(3);
+    oss << "phase wall cpu" << std::endl;
+    print(oss, *root, 0);
+    oss << "total " << wall << ' ' << cpu << std::endl;
+    oss.flags(flags);
+    oss.precision(precision);
+}
+
+void Profiler::print(std::ostream &oss, const Node &node, std::size_t depth) {
+    for (auto &i: node.children) {
+        // nesting is shown by the indentation
+        oss << std::string(2 * depth, ' ') << i->name << ' ' << i->wall << ' ' << i->cpu << std::endl;
+        print(oss, *i, depth + 1);
+    }
+}
+
+void Profiler::writeTrace(const std::string &path) {
+    std::lock_guard guard(lock);
+    Writer writer(path);
+    writer << std::string_view("{\"traceEvents\":[");
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        auto &event = events[i];
+        writer << std::string_view(i ? ",\n" : "\n") << std::string_view("{\"name\":\"");
+        for (auto c: event.name) {
+            if (c == '"' || c == '\\')
+                writer << '\\';
+            writer << c;
+        }
+        writer << std::string_view("\",\"cat\":\"") << std::string_view(event.category)
+               << std::string_view("\",\"ph\":\"X\",\"pid\":1,\"tid\":") << event.thread
+               << std::string_view(",\"ts\":") << event.start << std::string_view(",\"dur\":") << event.duration
+               << '}';
+    }
+    writer << std::string_view("\n],\"displayTimeUnit\":\"ms\"}\n");
+}
+
+double Profiler::threadTime() {
+    timespec time{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return (double) time.tv_sec * 1000 + (double) time.tv_nsec / 1e6;
+}
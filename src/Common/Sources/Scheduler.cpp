@@ -0,0 +1,64 @@
+#include "Scheduler.h"
+
+#include <algorithm>
+#include <thread>
+
+Scheduler::Scheduler(std::size_t new_threads) : threads(std::max<std::size_t>(new_threads, 1)) {
+    for (std::size_t i = 0; i < threads; ++i)
+        queues.emplace_back(std::make_unique<Queue>());
+}
+
+void Scheduler::run(const std::vector<std::function<void()>> &tasks) {
+    for (std::size_t i = 0; i < tasks.size(); ++i)
+        queues[i % threads]->tasks.push_back(i);
+
+    std::vector<std::exception_ptr> errors(tasks.size());
+
+    // the calling thread is the first worker
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < std::min(threads, tasks.size()); ++i)
+        workers.emplace_back(&Scheduler::work, this, i, std::cref(tasks), std::ref(errors));
+    work(0, tasks, errors);
+    for (auto &i: workers)
+        i.join();
+
+    for (auto &i: errors)
+        if (i)
+            std::rethrow_exception(i);
+}
+
+bool Scheduler::take(std::size_t worker, std::size_t &task) {
+    {
+        std::lock_guard guard(queues[worker]->lock);
+        auto &own = queues[worker]->tasks;
+        if (!own.empty()) {
+            task = own.back();
+            own.pop_back();
+            return true;
+        }
+    }
+
+    // tasks do not create new ones, so the empty queues stay empty
+    for (std::size_t i = 1; i < threads; ++i) {
+        auto &victim = *queues[(worker + i) % threads];
+        std::lock_guard guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void Scheduler::work(std::size_t worker, const std::vector<std::function<void()>> &tasks,
+                     std::vector<std::exception_ptr> &errors) {
+    std::size_t task;
+    while (take(worker, task)) {
+        try {
+            tasks[task]();
+        } catch (...) {
+            errors[task] = std::current_exception();
+        }
+    }
+}
@@ -0,0 +1,203 @@
+#include "Server.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <csignal>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static bool sendAll(int descriptor, const void *data, std::size_t size) {
+    auto bytes = static_cast<const char *>(data);
+    while (size) {
+        auto res = send(descriptor, bytes, size, MSG_NOSIGNAL);
+        if (res < 0 && errno == EINTR)
+            continue;
+        if (res <= 0)
+            return false;
+        bytes += res;
+        size -= res;
+    }
+    return true;
+}
+
+static bool receiveAll(int descriptor, void *data, std::size_t size) {
+    auto bytes = static_cast<char *>(data);
+    while (size) {
+        auto res = recv(descriptor, bytes, size, 0);
+        if (res < 0 && errno == EINTR)
+            continue;
+        if (res <= 0)
+            return false;
+        bytes += res;
+        size -= res;
+    }
+    return true;
+}
+
+// listening socket of the running server, which the signal shuts down
+static volatile std::sig_atomic_t running = -1;
+
+static void stop(int) {
+    if (running >= 0)
+        shutdown(running, SHUT_RDWR);
+}
+
+static sockaddr_un address(const std::string &path) {
+    sockaddr_un res{};
+    res.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(res.sun_path))
+        throw std::invalid_argument("ERROR. Path of the socket " + path + " is too long.");
+    std::strcpy(res.sun_path, path.c_str());
+    return res;
+}
+
+Server::Server(const std::string &new_path, std::size_t new_workers, Handler new_handler)
+        : path(new_path), workers(std::max<std::size_t>(new_workers, 1)), handler(std::move(new_handler)) {
+    auto place = address(path);
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+        throw std::invalid_argument("ERROR. Cannot create the socket " + path + ".");
+
+    // socket left by the server, which has not ended properly
+    unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr *>(&place), sizeof(place)) < 0 || listen(listener, 128) < 0) {
+        close(listener);
+        throw std::invalid_argument("ERROR. Cannot listen on the socket " + path + ".");
+    }
+}
+
+Server::~Server() {
+    close(listener);
+    unlink(path.c_str());
+}
+
+void Server::run() {
+    // client, which has gone, must not stop the server
+    std::signal(SIGPIPE, SIG_IGN);
+    running = listener;
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+
+    std::vector<std::thread> pool;
+    for (std::size_t i = 0; i < workers; ++i)
+        pool.emplace_back(&Server::work, this);
+
+    while (true) {
+        auto connection = accept(listener, nullptr, nullptr);
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break;
+        }
+
+        std::unique_lock guard(lock);
+        space.wait(guard, [this]() { return connections.size() < 4 * workers; });
+        connections.push(connection);
+        ready.notify_one();
+    }
+
+    // the server is stopped, the workers end after the accepted requests
+    running = -1;
+    {
+        std::lock_guard guard(lock);
+        connections.push(-1);
+        ready.notify_all();
+    }
+    for (auto &i: pool)
+        i.join();
+}
+
+void Server::work() {
+    while (true) {
+        int connection;
+        {
+            std::unique_lock guard(lock);
+            ready.wait(guard, [this]() { return !connections.empty(); });
+            connection = connections.front();
+            // the mark of the end stays for the other workers
+            if (connection < 0)
+                return;
+            connections.pop();
+            space.notify_one();
+        }
+        serve(connection);
+        close(connection);
+    }
+}
+
+void Server::serve(int connection) {
+    std::uint32_t count;
+    if (!receiveAll(connection, &count, sizeof(count)) || !count)
+        return;
+
+    // directory of the client goes first
+    std::vector<std::string> strings;
+    for (std::uint32_t i = 0; i < count; ++i) {
+        std::uint32_t size;
+        if (!receiveAll(connection, &size, sizeof(size)) || size > (1 << 20))
+            return;
+        std::string text(size, '\0');
+        if (!receiveAll(connection, text.data(), size))
+            return;
+        strings.emplace_back(std::move(text));
+    }
+
+    std::vector<std::string> args(strings.begin() + 1, strings.end());
+    unsigned char status = EXIT_FAILURE;
+    try {
+        status = handler(args, strings[0], connection);
+    } catch (std::exception &) {
+        // the client has gone
+        return;
+    }
+    sendAll(connection, &status, 1);
+}
+
+int Server::request(const std::string &path, const std::vector<std::string> &args) {
+    auto place = address(path);
+    auto connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connection < 0 || connect(connection, reinterpret_cast<sockaddr *>(&place), sizeof(place)) < 0) {
+        if (connection >= 0)
+            close(connection);
+        throw std::invalid_argument("ERROR. Cannot connect to the server " + path + ".");
+    }
+
+    std::vector<std::string> strings = {std::string(getcwd(nullptr, 0) ?: "")};
+    strings.insert(strings.end(), args.begin(), args.end());
+    auto count = (std::uint32_t) strings.size();
+    bool sent = sendAll(connection, &count, sizeof(count));
+    for (auto &i: strings) {
+        auto size = (std::uint32_t) i.size();
+        sent = sent && sendAll(connection, &size, sizeof(size)) && sendAll(connection, i.data(), i.size());
+    }
+    if (!sent) {
+        close(connection);
+        throw std::invalid_argument("ERROR. Cannot send the request to the server " + path + ".");
+    }
+
+    // the last byte is the status, so one byte is always held back
+    std::vector<char> buffer(1 << 16);
+    bool held = false;
+    char last = 0;
+    while (true) {
+        auto res = recv(connection, buffer.data(), buffer.size(), 0);
+        if (res < 0 && errno == EINTR)
+            continue;
+        if (res <= 0)
+            break;
+        if (held)
+            write(STDOUT_FILENO, &last, 1);
+        write(STDOUT_FILENO, buffer.data(), res - 1);
+        last = buffer[res - 1];
+        held = true;
+    }
+    close(connection);
+
+    if (!held)
+        throw std::invalid_argument("ERROR. Server " + path + " has not answered.");
+    return (unsigned char) last;
+}
@@ -0,0 +1,126 @@
+#include "Writer.h"
+
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+Writer::Writer(int new_descriptor) : descriptor(new_descriptor), buffer(capacity) {}
+
+Writer::Writer(const std::string &path) : buffer(capacity) {
+    descriptor = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (descriptor < 0)
+        throw std::invalid_argument("ERROR. Cannot open the file " + path + ".");
+    owned = true;
+}
+
+Writer::~Writer() {
+    // the error cannot go out of the destructor, the output is lost anyway
+    try {
+        flush();
+    } catch (std::invalid_argument &) {}
+    if (owned)
+        close(descriptor);
+}
+
+Writer &Writer::operator<<(char symbol) {
+    if (used == buffer.size())
+        flush();
+    buffer[used++] = symbol;
+    return *this;
+}
+
+Writer &Writer::operator<<(std::string_view text) {
+    append(text.data(), text.size());
+    return *this;
+}
+
+Writer &Writer::operator<<(long long number) {
+    auto place = reserve(24);
+    used = std::to_chars(place, place + 24, number).ptr - buffer.data();
+    return *this;
+}
+
+Writer &Writer::operator<<(std::size_t number) {
+    auto place = reserve(24);
+    used = std::to_chars(place, place + 24, number).ptr - buffer.data();
+    return *this;
+}
+
+Writer &Writer::operator<<(double number) {
+    // the biggest double has 309 digits before the point
+    auto place = reserve(330);
+    used = std::to_chars(place, place + 330, number, std::chars_format::fixed, 6).ptr - buffer.data();
+    return *this;
+}
+
+void Writer::flush() {
+    std::size_t written = 0;
+    while (written < used) {
+        auto res = write(descriptor, buffer.data() + written, used - written);
+        if (res < 0)
+            throw std::invalid_argument("ERROR. Cannot write the output.");
+        written += res;
+    }
+    flushed += used;
+    used = 0;
+}
+
+std::size_t Writer::position() const {
+    return flushed + used;
+}
+
+void Writer::patch(std::size_t place, std::string_view text) {
+    // part in the buffer
+    if (place + text.size() > flushed) {
+        auto skip = place < flushed ? flushed - place : 0;
+        std::memcpy(buffer.data() + place + skip - flushed, text.data() + skip, text.size() - skip);
+        text = text.substr(0, skip);
+    }
+
+    std::size_t written = 0;
+    while (written < text.size()) {
+        auto res = pwrite(descriptor, text.data() + written, text.size() - written, (off_t) (place + written));
+        if (res < 0)
+            throw std::invalid_argument("ERROR. Cannot rewrite the output.");
+        written += res;
+    }
+}
+
+Writer::int_type Writer::overflow(int_type symbol) {
+    if (!traits_type::eq_int_type(symbol, traits_type::eof()))
+        *this << traits_type::to_char_type(symbol);
+    return traits_type::not_eof(symbol);
+}
+
+std::streamsize Writer::xsputn(const char *text, std::streamsize size) {
+    append(text, size);
+    return size;
+}
+
+void Writer::append(const char *text, std::size_t size) {
+    if (used + size > buffer.size()) {
+        flush();
+        // too long to be buffered
+        if (size > buffer.size()) {
+            std::size_t written = 0;
+            while (written < size) {
+                auto res = write(descriptor, text + written, size - written);
+                if (res < 0)
+                    throw std::invalid_argument("ERROR. Cannot write the output.");
+                written += res;
+            }
+            flushed += size;
+            return;
+        }
+    }
+    std::memcpy(buffer.data() + used, text, size);
+    used += size;
+}
+
+char *Writer::reserve(std::size_t size) {
+    if (used + size > buffer.size())
+        flush();
+    return buffer.data() + used;
+}
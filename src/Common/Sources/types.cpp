@@ -10,6 +10,10 @@ bool IntType::canConvertToThisType(const Type *other) const {
     return false;
 }
 
+int IntType::getBits() const {
+    return bits;
+}
+
 std::string IntType::toString() {
     return "i" + std::to_string(bits);
 }
@@ -11,6 +11,8 @@
 #include <algorithm>
 
 #include "types.h"
+#include "MemoryReport.h"
+#include "Hash.h"
 #include "IR.h"
 
 
@@ -176,6 +178,10 @@ namespace AST {
 
         virtual ~ASTNode() = default;
 
+        static void *operator new(std::size_t size) { return MemoryReport::allocate<ASTNode>(size, MemoryReport::AST); }
+
+        static void operator delete(void *object) { MemoryReport::release(object); }
+
         // needs for the debugger and for break pointer
         void addLineNumber(int line_num);
 
@@ -194,6 +200,10 @@ namespace AST {
         // generate the corespond IR lines to this node
         virtual IR::Value * generateIR(IR::Context &) = 0;
 
+        // collects the variables, which the node might change (assigns, increments, declares or takes
+        // the address of), and counts its nodes. "*" stands for a change through a pointer or by a call
+        virtual void collectChanges(std::set<std::string> &, std::size_t &);
+
     private:
         int line;
     };
@@ -281,6 +291,9 @@ namespace AST {
         // gets the set of the names, which must be decl before this variable
         virtual std::set<std::string> getVarNames() = 0;
 
+        // value known before the run. nullptr, if it is computed by the program
+        virtual std::unique_ptr<IR::Const> constantValue(IR::Context &);
+
     private:
     };
 
@@ -302,6 +315,14 @@ namespace AST {
 
         IR::Value * generateIR(IR::Context &) override;
 
+        ASTExpression *getLeft();
+
+        ASTExpression *getRight();
+
+        IR::IRArithOp::Operator getOperator();
+
+        void collectChanges(std::set<std::string> &, std::size_t &) override;
+
 
     private:
         std::unique_ptr<ASTExpression> left, right;
@@ -330,6 +351,14 @@ namespace AST {
 
         IR::Value * generateIR(IR::Context &) override;
 
+        std::unique_ptr<IR::Const> constantValue(IR::Context &) override;
+
+        Operator getOperator();
+
+        ASTExpression *getValue();
+
+        void collectChanges(std::set<std::string> &, std::size_t &) override;
+
 
     private:
         Operator op;
@@ -356,6 +385,8 @@ namespace AST {
 
         IR::Value * generateIR(IR::Context &) override;
 
+        void collectChanges(std::set<std::string> &, std::size_t &) override;
+
 
     private:
         std::unique_ptr<ASTExpression> name;
@@ -389,6 +420,8 @@ namespace AST {
 
         IR::Value * generateIR(IR::Context &) override;
 
+        void collectChanges(std::set<std::string> &, std::size_t &) override;
+
 
     private:
         std::unique_ptr<ASTExpression> name;
@@ -410,6 +443,10 @@ namespace AST {
 
         IR::Value * generateIR(IR::Context &) override;
 
+        std::unique_ptr<IR::Const> constantValue(IR::Context &) override;
+
+        long long getValue();
+
 
     private:
         long long int value = 0;
@@ -428,6 +465,8 @@ namespace AST {
 
         IR::Value * generateIR(IR::Context &) override;
 
+        std::unique_ptr<IR::Const> constantValue(IR::Context &) override;
+
 
     private:
         double value = 0;
@@ -446,6 +485,8 @@ namespace AST {
 
         IR::Value * generateIR(IR::Context &) override;
 
+        std::unique_ptr<IR::Const> constantValue(IR::Context &) override;
+
 
     private:
         bool value = false;
@@ -465,6 +506,10 @@ namespace AST {
 
         IR::Value * generateIR(IR::Context &) override;
 
+        std::unique_ptr<IR::Const> constantValue(IR::Context &) override;
+
+        void collectChanges(std::set<std::string> &, std::size_t &) override;
+
 
     private:
         // type of the structure
@@ -550,6 +595,12 @@ namespace AST {
 
         virtual std::vector<dispatchedDecl> globalPreInit() = 0;
 
+        void collectChanges(std::set<std::string> &, std::size_t &) override;
+
+        std::vector<std::string> &getNames();
+
+        std::vector<std::unique_ptr<ASTExpression>> &getValues();
+
         // It used, then declaration created by the program itself and servers to accept structure type from a function
         // and after that assign it to each individuals
         bool dispatcher = false;
@@ -599,6 +650,8 @@ namespace AST {
 
         IR::Value * generateIR(IR::Context &) override;
 
+        void collectChanges(std::set<std::string> &, std::size_t &) override;
+
     private:
         std::unique_ptr<ASTVarDeclaration> function_dispatch;
 
@@ -634,6 +687,8 @@ namespace AST {
 
         IR::Value * generateIR(IR::Context &) override;
 
+        void collectChanges(std::set<std::string> &, std::size_t &) override;
+
     private:
         std::vector<std::unique_ptr<AST::Statement>> statements;
     };
@@ -675,6 +730,8 @@ namespace AST {
 
         IR::Value * generateIR(IR::Context &) override;
 
+        void collectChanges(std::set<std::string> &, std::size_t &) override;
+
     private:
         // might have a multiple returns
         // in that case, it will be converted to a structure later
@@ -695,6 +752,8 @@ namespace AST {
 
         IR::Value * generateIR(IR::Context &) override;
 
+        void collectChanges(std::set<std::string> &, std::size_t &) override;
+
     private:
         std::unique_ptr<ASTExpression> expr;
 
@@ -717,6 +776,8 @@ namespace AST {
 
         IR::Value * generateIR(IR::Context &) override;
 
+        void collectChanges(std::set<std::string> &, std::size_t &) override;
+
     private:
         std::unique_ptr<AST::ASTExpression> expr;
 
@@ -740,7 +801,42 @@ namespace AST {
 
         IR::Value * generateIR(IR::Context &) override;
 
+        void collectChanges(std::set<std::string> &, std::size_t &) override;
+
     private:
+        /**
+         * Counted loop: the integer variable is declared by the init clause, compared with the invariant
+         * bound by the condition and changed by the constant step only by the iterate clause
+         */
+        struct Induction {
+            std::string name;
+
+            ASTBinaryOperator *condition = nullptr;
+
+            long long step = 0;
+
+            // values of the init and of the bound, if they are constants
+            bool constant = false;
+            long long init = 0, bound = 0;
+
+            // nodes of the body and of the iterate clause
+            std::size_t size = 0;
+
+            // number of the iterations, if it is known. -1 otherwise
+            long long trips();
+        };
+
+        bool findInduction(Induction &);
+
+        // condition of the loop, where the bound is moved by the shift towards the variable
+        IR::Value *generateCondition(IR::Context &, long long);
+
+        // single iteration: body and the iterate clause
+        void generateIteration(IR::Context &);
+
+        // rotated loop with the copies of the iteration. Leaves to the label, when the condition fails
+        void generateLoop(IR::Context &, std::size_t, long long, IR::Value *);
+
         std::vector<std::unique_ptr<AST::Statement>> init_clause, iterate_clause;
 
         std::unique_ptr<AST::ASTExpression> if_clause;
@@ -764,6 +860,14 @@ namespace AST {
 
         IR::Value * generateIR(IR::Context &) override;
 
+        TypeOfAssign getType();
+
+        std::vector<std::unique_ptr<AST::ASTExpression>> &getVariables();
+
+        std::vector<std::unique_ptr<AST::ASTExpression>> &getValues();
+
+        void collectChanges(std::set<std::string> &, std::size_t &) override;
+
         // It used then assign it a part of a dispatch variable and it does not need to be assigned.
         bool dispatcher = false;
 
@@ -791,6 +895,8 @@ namespace AST {
         Type *checker(Context &) override;
 
         IR::Value * generateIR(IR::Context &) override;
+
+        void collectChanges(std::set<std::string> &, std::size_t &) override;
     private:
         std::unique_ptr<AST::ASTExpression> expression;
 
@@ -807,6 +913,8 @@ namespace AST {
         Type *checker(Context &) override;
 
         IR::Value * generateIR(IR::Context &) override;
+
+        void collectChanges(std::set<std::string> &, std::size_t &) override;
     private:
         std::unique_ptr<AST::ASTExpression> expression;
 
@@ -833,9 +941,24 @@ namespace AST {
 
         IR::Value * generateIR(IR::Context &) override;
 
+        // name of the function (of the method after the declaration)
+        std::string getName();
+
+        // does the function return a single value, which is not a structure
+        bool returnsValue();
+
+        // hashes of the tokens of the signature and of the body
+        void setDigests(std::uint64_t, std::uint64_t);
+
+        std::uint64_t getSignatureDigest();
+
+        std::uint64_t getBodyDigest();
+
     private:
         std::string name;
 
+        std::uint64_t signature_digest = 0, body_digest = 0;
+
         std::vector<std::pair<std::vector<std::string>, std::unique_ptr<ASTType>>> params;
 
         std::vector<std::unique_ptr<AST::ASTType>> return_type;
@@ -880,13 +1003,29 @@ namespace AST {
 
         Type *checker(Context &) override;
 
+        // declares the types, the globals and the functions without checking the bodies of the functions
+        void declare(Context &);
+
         std::queue<dispatchedDecl> topSort(std::vector<dispatchedDecl>);
 
         IR::Value * generateIR(IR::Context &) override;
 
+        // creates the program with the globals (and the function, which initialises them)
+        void generateGlobalsIR(IR::Context &);
+
+        std::vector<std::unique_ptr<Function>> &getFunctions();
+
+        // adds the hash of the tokens of the global declaration
+        void addDigest(std::uint64_t);
+
+        // hash of the global declarations and of the signatures of all functions
+        std::uint64_t getDigest();
+
     private:
         std::string name;
 
+        Hash declarations;
+
         std::vector<std::unique_ptr<ASTDeclaration>> typeDeclarations;
 
         std::vector<std::unique_ptr<ASTDeclaration>> varDeclarations;
@@ -902,6 +1041,8 @@ namespace AST {
 
         IR::Value * generateIR(IR::Context &) override;
 
+        void collectChanges(std::set<std::string> &, std::size_t &) override;
+
         std::set<std::string> getVarNames() override;
 
 
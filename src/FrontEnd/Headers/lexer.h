@@ -6,6 +6,8 @@
 #include <string>
 #include <map>
 
+#include "Hash.h"
+#include "Profiler.h"
 
 /*
  * Lexer returns tokens [0-255] if it is an unknown character, otherwise one of these for known things.
@@ -182,6 +184,17 @@ public:
 
     Token gettok();
 
+    // hash of the tokens read since the last call
+    std::uint64_t takeDigest();
+
+    // time of reading the tokens is measured, when it is on
+    void measureTime(bool on) { measure = on; }
+
+    // wall and CPU time of reading the tokens in milliseconds
+    double getWallTime() const { return wall_time; }
+
+    double getCpuTime() const { return cpu_time; }
+
     const std::string &identifierStr() const { return this->m_IdentifierStr; }
 
     int numVal() { return this->m_NumVal; }
@@ -225,6 +238,14 @@ private:
 
     int if_new_line_appear = 0;
 
+    Hash digest;
+
+    bool measure = false;
+
+    double wall_time = 0, cpu_time = 0;
+
+    Token nextToken();
+
     std::string inner_func = "\n\nfunc scan(a *int) {\n"
                       "    var tmp *int\n"
                       "    scan_char(tmp)\n"
@@ -6,10 +6,12 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <functional>
 
 class Parser {
 public:
-    Parser(std::string);
+    // lexing is measured as a phase of the profiler, if it is given
+    explicit Parser(std::string, Profiler * = nullptr);
 
     ~Parser() = default;
 
@@ -129,6 +131,8 @@ private:
 
     Lexer lexer;
 
+    Profiler *profiler;
+
 };
 
 
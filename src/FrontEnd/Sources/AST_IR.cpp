@@ -107,12 +107,40 @@ IR::Value *AST::ASTUnaryOperator::generateIR(IR::Context &ctx) {
             }
             auto res = std::make_unique<IR::IRLoad>(ctx.counter);
             res->addLoadFrom(value->generateIR(ctx));
+            res->setTypeOfResult(typeOfNode);
             return ctx.buildInstruction(std::move(res));
         }
     }
 }
 
+std::unique_ptr<IR::Const> AST::ASTExpression::constantValue(IR::Context &) {
+    return nullptr;
+}
+
+std::unique_ptr<IR::Const> AST::ASTUnaryOperator::constantValue(IR::Context &ctx) {
+    if (op != PLUS && op != MINUS)
+        return nullptr;
+    auto res = value->constantValue(ctx);
+    if (op == PLUS)
+        return res;
+
+    long long nothing = 0;
+    if (auto number = dynamic_cast<IR::IntConst *>(res.get())) {
+        auto negated = std::make_unique<IR::IntConst>(nothing);
+        negated->addValue(-number->getValue());
+        return negated;
+    }
+    if (auto number = dynamic_cast<IR::DoubleConst *>(res.get())) {
+        auto negated = std::make_unique<IR::DoubleConst>(nothing);
+        negated->addValue(-number->getValue());
+        return negated;
+    }
+    return nullptr;
+}
+
 IR::Value *AST::ASTFunctionCall::generateIR(IR::Context &ctx) {
+    // result is a value even for the upper node, which asks for an address
+    ctx.l_value = false;
     std::vector < IR::Value * > arguments;
     for (auto &i: arg) {
         if (!dynamic_cast<StructType*>(i->typeOfNode)){
@@ -141,6 +169,7 @@ IR::Value *AST::ASTFunctionCall::generateIR(IR::Context &ctx) {
     }
 
     auto func_pointer = dynamic_cast<IR::IRCall *>(name->generateIR(ctx));
+    func_pointer->setTypeOfResult(typeOfNode);
     for (auto &i: arguments)
         func_pointer->addArg(i);
     if (!ctx.name_of_dispatched_struct.empty()) {
@@ -148,6 +177,14 @@ IR::Value *AST::ASTFunctionCall::generateIR(IR::Context &ctx) {
         func_pointer->addArg(ctx.getVariable(ctx.name_of_dispatched_struct));
         return ctx.getVariable(ctx.name_of_dispatched_struct);
     }
+    if (!name_for_return_arg.empty() && dynamic_cast<StructType *>(typeOfNode)) {
+        // returned structure is written into the temporary, which address is the result
+        auto result = std::make_unique<IR::IRAlloca>(ctx.counter);
+        result->addType(type_for_return_arg);
+        auto pointer_to_result = ctx.buildInstruction(std::move(result));
+        func_pointer->addArg(pointer_to_result);
+        return pointer_to_result;
+    }
     // return the function return
     return func_pointer;
 }
@@ -214,6 +251,7 @@ IR::Value *AST::ASTMemberAccess::generateIR(IR::Context &ctx) {
 
     auto load = std::make_unique<IR::IRLoad>(ctx.counter);
     load->addLoadFrom(link_to_member);
+    load->setTypeOfResult(typeOfNode);
     return ctx.buildInstruction(std::move(load));
 }
 
@@ -224,6 +262,13 @@ IR::Value *AST::ASTIntNumber::generateIR(IR::Context &ctx) {
     return ctx.buildInstruction(std::move(res));
 }
 
+std::unique_ptr<IR::Const> AST::ASTIntNumber::constantValue(IR::Context &) {
+    long long nothing = 0;
+    auto res = std::make_unique<IR::IntConst>(nothing);
+    res->addValue(value);
+    return res;
+}
+
 IR::Value *AST::ASTFloatNumber::generateIR(IR::Context &ctx) {
     auto res = std::make_unique<IR::DoubleConst>(ctx.counter);
     res->addValue(value);
@@ -231,6 +276,13 @@ IR::Value *AST::ASTFloatNumber::generateIR(IR::Context &ctx) {
     return ctx.buildInstruction(std::move(res));
 }
 
+std::unique_ptr<IR::Const> AST::ASTFloatNumber::constantValue(IR::Context &) {
+    long long nothing = 0;
+    auto res = std::make_unique<IR::DoubleConst>(nothing);
+    res->addValue(value);
+    return res;
+}
+
 IR::Value *AST::ASTBoolNumber::generateIR(IR::Context &ctx) {
     auto res = std::make_unique<IR::IntConst>(ctx.counter);
     res->addValue(value ? 1 : 0);
@@ -238,6 +290,13 @@ IR::Value *AST::ASTBoolNumber::generateIR(IR::Context &ctx) {
     return ctx.buildInstruction(std::move(res));
 }
 
+std::unique_ptr<IR::Const> AST::ASTBoolNumber::constantValue(IR::Context &) {
+    long long nothing = 0;
+    auto res = std::make_unique<IR::IntConst>(nothing);
+    res->addValue(value ? 1 : 0);
+    return res;
+}
+
 IR::Value *AST::ASTStruct::generateIR(IR::Context &ctx) {
     auto alloca = std::make_unique<IR::IRAlloca>(ctx.counter);
     alloca->addType(typeOfNode);
@@ -245,6 +304,9 @@ IR::Value *AST::ASTStruct::generateIR(IR::Context &ctx) {
 
     auto pointer_alloca = ctx.buildInstruction(std::move(alloca));
 
+    // fields, which are not listed, are zero
+    if (values.size() < dynamic_cast<StructType *>(typeOfNode)->getFields().size())
+        ctx.zeroStructure(pointer_alloca, dynamic_cast<StructType *>(typeOfNode));
 
     for (auto &i : values){
         auto value = i.second->generateIR(ctx);
@@ -263,6 +325,26 @@ IR::Value *AST::ASTStruct::generateIR(IR::Context &ctx) {
     return pointer_alloca;
 }
 
+std::unique_ptr<IR::Const> AST::ASTStruct::constantValue(IR::Context &ctx) {
+    auto structure = dynamic_cast<StructType *>(typeOfNode);
+    auto fields = structure->getFields();
+
+    // fields, which are not listed, are zero
+    std::vector<std::unique_ptr<IR::Const>> field_values(fields.size());
+    for (auto &i: values) {
+        auto field = structure->getFieldOrder(i.first);
+        field_values[field] = i.second->constantValue(ctx);
+        if (!field_values[field])
+            return nullptr;
+    }
+
+    long long nothing = 0;
+    auto res = std::make_unique<IR::StructConst>(nothing);
+    for (std::size_t i = 0; i < fields.size(); ++i)
+        res->addConst(field_values[i] ? std::move(field_values[i]) : ctx.getBasicValue(fields[i].second));
+    return res;
+}
+
 IR::Value *AST::ASTVar::generateIR(IR::Context &ctx) {
 
     // Variable
@@ -275,6 +357,7 @@ IR::Value *AST::ASTVar::generateIR(IR::Context &ctx) {
         }
         auto res = std::make_unique<IR::IRLoad>(ctx.counter);
         res->addLoadFrom(link);
+        res->setTypeOfResult(typeOfNode);
 
         return ctx.buildInstruction(std::move(res));
     }
@@ -291,6 +374,34 @@ IR::Value *AST::ASTTypeDeclaration::generateIR(IR::Context &ctx) {
     return nullptr;
 }
 
+// global with the value known before the run is placed into the .data segment. Other values are stored into it
+// by the function before main, which is being built now
+static void generateGlobal(IR::Context &ctx, const std::string &name, Type *type,
+                           std::unique_ptr<AST::ASTExpression> *value) {
+    if (value && dynamic_cast<SeqType *>((*value)->typeOfNode))
+        throw std::invalid_argument("ERROR. Global " + name + " cannot take one of the multiple returns.");
+
+    auto res = std::make_unique<IR::IRGlobal>(ctx.counter);
+    res->addType(type);
+    ctx.addVariable(name, res.get());
+
+    auto constant = value ? (*value)->constantValue(ctx) : nullptr;
+    if (constant || !value) {
+        res->addBasicValue(constant ? std::move(constant) : ctx.getBasicValue(type));
+        ctx.program->addGlobDecl(std::move(res));
+        return;
+    }
+    ctx.program->addGlobDecl(std::move(res));
+
+    std::vector<std::unique_ptr<AST::ASTExpression>> var;
+    var.emplace_back(std::make_unique<AST::ASTVar>(name));
+    std::vector<std::unique_ptr<AST::ASTExpression>> val;
+    val.emplace_back(std::move(*value));
+    auto assign = std::make_unique<AST::ASTAssign>(std::move(var), std::move(val), AST::ASTAssign::ASSIGN);
+    assign->generateIR(ctx);
+    *value = std::move(assign->getValues()[0]);
+}
+
 IR::Value *AST::ASTVarDeclaration::generateIR(IR::Context &ctx) {
     if (ctx.inside_dispatch) {
         ctx.inside_dispatch = false;
@@ -298,17 +409,9 @@ IR::Value *AST::ASTVarDeclaration::generateIR(IR::Context &ctx) {
     }
 
     if (ctx.Global) {
-        for (auto i = 0; i < name.size(); ++i) {
-            auto res = std::make_unique<IR::IRGlobal>(ctx.counter);
-
-            if (type)
-                res->addType(type->typeOfNode);
-            else
-                res->addType(value[i]->typeOfNode);
-
-            ctx.addVariable(name[i], res.get());
-            ctx.program->addGlobDecl(std::move(res));
-        }
+        for (auto i = 0; i < name.size(); ++i)
+            generateGlobal(ctx, name[i], type ? type->typeOfNode : value[i]->typeOfNode,
+                           value.empty() ? nullptr : &value[i]);
         return nullptr;
     }
 
@@ -336,7 +439,12 @@ IR::Value *AST::ASTVarDeclaration::generateIR(IR::Context &ctx) {
             res->addBasicValue(ctx.getBasicValue(type_of_alloca));
 
         ctx.addVariable(name[i], res.get());
-        ctx.buildInstruction(std::move(res));
+        auto pointer = ctx.buildInstruction(std::move(res));
+
+        // structure starts zeroed. It may be built in the memory of the caller, which holds the old value
+        if (value.empty())
+            if (auto structure = dynamic_cast<StructType *>(type_of_alloca))
+                ctx.zeroStructure(pointer, structure);
         if (!value.empty() && value[i]) {
             std::vector<std::unique_ptr<AST::ASTExpression>> var;
             var.emplace_back(std::make_unique<AST::ASTVar>(name[i]));
@@ -347,6 +455,8 @@ IR::Value *AST::ASTVarDeclaration::generateIR(IR::Context &ctx) {
             assign->dispatcher = dispatcher;
             assign->generateIR(ctx);
 
+            // declaration is generated again by the unrolled loops
+            value[i] = std::move(assign->getValues()[0]);
         }
     }
     return nullptr;
@@ -354,17 +464,9 @@ IR::Value *AST::ASTVarDeclaration::generateIR(IR::Context &ctx) {
 
 IR::Value *AST::ASTConstDeclaration::generateIR(IR::Context &ctx) {
     if (ctx.Global) {
-        for (auto i = 0; i < name.size(); ++i) {
-            auto res = std::make_unique<IR::IRGlobal>(ctx.counter);
-
-            if (type)
-                res->addType(type->typeOfNode);
-            else
-                res->addType(value[i]->typeOfNode);
-
-            ctx.addVariable(name[i], res.get());
-            ctx.program->addGlobDecl(std::move(res));
-        }
+        for (auto i = 0; i < name.size(); ++i)
+            generateGlobal(ctx, name[i], type ? type->typeOfNode : value[i]->typeOfNode,
+                           value.empty() ? nullptr : &value[i]);
         return nullptr;
     }
     for (auto i = 0; i < name.size(); ++i) {
@@ -414,7 +516,21 @@ IR::Value *AST::ASTContinue::generateIR(IR::Context &ctx) {
 IR::Value *AST::ASTReturn::generateIR(IR::Context &ctx) {
     auto res = std::make_unique<IR::IRRet>(ctx.counter);
 
-    if (return_value.size() == 1) {
+    if (return_value.size() == 1 && !ctx.name_if_return_become_arg.empty()) {
+        // returned structure is copied into the place given by the caller
+        ctx.l_value = true;
+        auto value_pointer = return_value[0]->generateIR(ctx);
+
+        auto load_of_st = std::make_unique<IR::IRLoad>(ctx.counter);
+        load_of_st->addLoadFrom(ctx.getVariable(ctx.name_if_return_become_arg));
+        auto ptr_to_st = ctx.buildInstruction(std::move(load_of_st));
+
+        auto copy = std::make_unique<IR::IRMemCopy>(ctx.counter);
+        copy->addCopyFrom(value_pointer);
+        copy->addCopyTo(ptr_to_st);
+        copy->addSize(ctx.type_of_return_arg->size());
+        ctx.buildInstruction(std::move(copy));
+    } else if (return_value.size() == 1) {
         // if single return -- just return it
         res->addRetVal(return_value[0]->generateIR(ctx));
     } else if (return_value.size() > 1){
@@ -496,29 +612,63 @@ IR::Value *AST::ASTFor::generateIR(IR::Context &ctx) {
     for (auto &i: init_clause)
         i->generateIR(ctx);
 
-    auto begin_loop_label = std::make_unique<IR::IRLabel>(ctx.counter);
-    auto jmp_to_begin = std::make_unique<IR::IRBranch>(ctx.counter);
-    jmp_to_begin->addBrTaken(begin_loop_label.get());
-    ctx.buildInstruction(std::move(jmp_to_begin));
+    auto end_loop_label = std::make_unique<IR::IRLabel>(ctx.counter);
+    ctx.addBreakLabel(end_loop_label.get());
 
-    auto begin_loop_label_pointer = ctx.buildInstruction(std::move(begin_loop_label));
+    Induction loop;
+    if (ctx.unroll_factor > 1 && findInduction(loop)) {
+        // few iterations -- straight code without the condition
+        auto trips = loop.trips();
+        if (trips >= 0 && trips <= (long long) (ctx.unroll_budget / loop.size)) {
+            for (long long i = 0; i < trips; ++i)
+                generateIteration(ctx);
+            ctx.buildInstruction(std::move(end_loop_label));
+            return nullptr;
+        }
 
-    auto val = if_clause->generateIR(ctx);
+        // copies of the iteration run, while all of them are in the bounds. The rest is done by the remainder loop
+        auto factor = std::min(ctx.unroll_factor, ctx.unroll_budget / loop.size);
+        if (factor > 1 && loop.condition->getOperator() != IR::IRArithOp::NE) {
+            auto remainder_label = std::make_unique<IR::IRLabel>(ctx.counter);
+            generateLoop(ctx, factor, ((long long) factor - 1) * loop.step, remainder_label.get());
+            ctx.buildInstruction(std::move(remainder_label));
+        }
+    }
 
-    auto jmp_condition = std::make_unique<IR::IRBranch>(ctx.counter);
+    generateLoop(ctx, 1, 0, end_loop_label.get());
+    ctx.buildInstruction(std::move(end_loop_label));
 
-    auto begin_loop_body_label = std::make_unique<IR::IRLabel>(ctx.counter);
-    auto end_loop_label = std::make_unique<IR::IRLabel>(ctx.counter);
-    auto begin_loop_post_label = std::make_unique<IR::IRLabel>(ctx.counter);
+    return nullptr;
+}
 
-    jmp_condition->addCond(val);
-    jmp_condition->addBrTaken(begin_loop_body_label.get());
-    jmp_condition->addBrNTaken(end_loop_label.get());
+IR::Value *AST::ASTFor::generateCondition(IR::Context &ctx, long long shift) {
+    if (!shift)
+        return if_clause->generateIR(ctx);
 
-    ctx.buildInstruction(std::move(jmp_condition));
+    // i < bound - shift
+    auto condition = dynamic_cast<ASTBinaryOperator *>(if_clause.get());
+    auto variable = condition->getLeft()->generateIR(ctx);
+    auto bound = condition->getRight()->generateIR(ctx);
 
-    ctx.buildInstruction(std::move(begin_loop_body_label));
-    ctx.addBreakLabel(end_loop_label.get());
+    auto distance = std::make_unique<IR::IntConst>(ctx.counter);
+    distance->addValue(shift);
+    auto distance_pointer = ctx.buildInstruction(std::move(distance));
+
+    auto moved = std::make_unique<IR::IRArithOp>(ctx.counter);
+    moved->setTypeOfOperation(IR::IRArithOp::MINUS);
+    moved->addChildren(bound, distance_pointer);
+    moved->setTypeOfResult(condition->getRight()->typeOfNode);
+    auto moved_pointer = ctx.buildInstruction(std::move(moved));
+
+    auto res = std::make_unique<IR::IRArithOp>(ctx.counter);
+    res->setTypeOfOperation(condition->getOperator());
+    res->addChildren(variable, moved_pointer);
+    res->setTypeOfResult(condition->typeOfNode);
+    return ctx.buildInstruction(std::move(res));
+}
+
+void AST::ASTFor::generateIteration(IR::Context &ctx) {
+    auto begin_loop_post_label = std::make_unique<IR::IRLabel>(ctx.counter);
     ctx.addContinueLabel(begin_loop_post_label.get());
 
     body->generateIR(ctx);
@@ -532,15 +682,31 @@ IR::Value *AST::ASTFor::generateIR(IR::Context &ctx) {
 
     for (auto &i: iterate_clause)
         i->generateIR(ctx);
+}
 
-    auto jmp_to_condition = std::make_unique<IR::IRBranch>(ctx.counter);
-    jmp_to_condition->addBrTaken(begin_loop_label_pointer);
+void AST::ASTFor::generateLoop(IR::Context &ctx, std::size_t copies, long long shift, IR::Value *exit_label) {
+    // rotated loop: the condition is tested once before the loop and then after every iteration,
+    // so the iteration ends by the single conditional jump back to the body
+    auto begin_loop_body_label = std::make_unique<IR::IRLabel>(ctx.counter);
 
-    ctx.buildInstruction(std::move(jmp_to_condition));
+    auto guard = std::make_unique<IR::IRBranch>(ctx.counter);
+    guard->addCond(generateCondition(ctx, shift));
+    guard->addBrTaken(begin_loop_body_label.get());
+    guard->addBrNTaken(exit_label);
 
-    ctx.buildInstruction(std::move(end_loop_label));
+    ctx.buildInstruction(std::move(guard));
 
-    return nullptr;
+    auto begin_loop_body_label_pointer = ctx.buildInstruction(std::move(begin_loop_body_label));
+
+    for (std::size_t i = 0; i < copies; ++i)
+        generateIteration(ctx);
+
+    auto jmp_condition = std::make_unique<IR::IRBranch>(ctx.counter);
+    jmp_condition->addCond(generateCondition(ctx, shift));
+    jmp_condition->addBrTaken(begin_loop_body_label_pointer);
+    jmp_condition->addBrNTaken(exit_label);
+
+    ctx.buildInstruction(std::move(jmp_condition));
 }
 
 IR::Value *AST::ASTAssign::generateIR(IR::Context &ctx) {
@@ -555,10 +721,11 @@ IR::Value *AST::ASTAssign::generateIR(IR::Context &ctx) {
             case ASSIGN: {
                 // if variable and value is a structure -- use instruction copy, instead of store
                 if (dynamic_cast<StructType *>(value[i]->typeOfNode)) {
-                    ctx.l_value = true;
-                    auto value_pointer = value[i]->generateIR(ctx);
+                    // destination first, so the returned structure can be built right in it
                     ctx.l_value = true;
                     auto variable_pointer = variable[i]->generateIR(ctx);
+                    ctx.l_value = true;
+                    auto value_pointer = value[i]->generateIR(ctx);
 
                     auto res = std::make_unique<IR::IRMemCopy>(ctx.counter);
                     res->addCopyFrom(value_pointer);
@@ -739,13 +906,27 @@ IR::Value *AST::Function::generateIR(IR::Context &ctx) {
     return nullptr;
 }
 
-IR::Value *AST::Program::generateIR(IR::Context &ctx) {
+void AST::Program::generateGlobalsIR(IR::Context &ctx) {
     ctx.program = std::make_unique<IR::IRProgram>(ctx.counter);
 
+    // dynamic values of the globals are stored by the function before main
+    auto init = std::make_unique<IR::IRFunc>(ctx.counter);
+    init->setName(IR::IRProgram::init_function);
+    ctx.setFunction(init.get());
+
     for (auto &i: varDeclarations)
         i->generateIR(ctx);
 
+    if (!init->getLinkToBody()->empty()) {
+        ctx.buildInstruction(std::make_unique<IR::IRRet>(ctx.counter));
+        ctx.program->addFunc(std::move(init));
+    }
+
     ctx.Global = false;
+}
+
+IR::Value *AST::Program::generateIR(IR::Context &ctx) {
+    generateGlobalsIR(ctx);
 
     for (auto &i: functions)
         i->generateIR(ctx);
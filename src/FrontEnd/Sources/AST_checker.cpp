@@ -171,7 +171,7 @@ AST::Context::convertTypesEq(std::unique_ptr<ASTExpression> &&left, std::unique_
         return std::make_pair(std::move(left), std::move(right));
 
     // if left less - change the left and return new one
-    if (typeGreater(left->typeOfNode, right->typeOfNode)) {
+    if (typeGreater(right->typeOfNode, left->typeOfNode)) {
         auto new_left = std::make_unique<AST::ASTCast>();
         new_left->setChild(std::move(left));
         new_left->setTypeCastTo(right->typeOfNode);
@@ -187,9 +187,12 @@ AST::Context::convertTypesEq(std::unique_ptr<ASTExpression> &&left, std::unique_
 bool AST::Context::typeGreater(Type *l_type, Type *r_type) {
     int l_level = -1, r_level = -1;
     static const std::vector<std::string> types_name = {"float", "int64", "int32", "int8"};
-    for (auto i = 4; i >= 1; --i)
+    for (auto i = 4; i >= 1; --i) {
         if (getTypeByTypeName(types_name[4 - i]) == l_type)
             l_level = i;
+        if (getTypeByTypeName(types_name[4 - i]) == r_type)
+            r_level = i;
+    }
     return l_level > r_level;
 }
 
@@ -954,6 +957,15 @@ void AST::Function::globalPreInit(Context &ctx) {
 
 
 Type *AST::Program::checker(Context &ctx) {
+    declare(ctx);
+
+    for (auto &i: functions)
+        i->checker(ctx);
+
+    return nullptr;
+}
+
+void AST::Program::declare(Context &ctx) {
     // type declarations
     {
         std::vector<dispatchedDecl> declarations;
@@ -1007,12 +1019,6 @@ Type *AST::Program::checker(Context &ctx) {
 
     // end of the declaration in global
     ctx.GlobalInit = false;
-
-
-    for (auto &i: functions)
-        i->checker(ctx);
-
-    return nullptr;
 }
 
 std::queue<AST::dispatchedDecl> AST::Program::topSort(std::vector<dispatchedDecl> g) {
@@ -1047,9 +1053,11 @@ void AST::ASTCast::setTypeCastTo(Type *new_type) {
 }
 
 Type *AST::ASTCast::checker(Context &ctx) {
-    throw std::invalid_argument("Never should be it.");
+    // cast is inserted by the checker itself, so it might be checked again
+    expr->checker(ctx);
+    return typeOfNode;
 }
 
 std::set<std::string> AST::ASTCast::getVarNames() {
-
+    return expr->getVarNames();
 }
\ No newline at end of file
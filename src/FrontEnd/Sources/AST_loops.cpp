@@ -0,0 +1,253 @@
+#include "AST.h"
+
+namespace {
+    // variable, which is changed by the assignment to the expression or by taking its address
+    void changedBy(AST::ASTExpression *expr, std::set<std::string> &changes) {
+        if (auto var = dynamic_cast<AST::ASTVar *>(expr))
+            changes.insert(var->getName());
+        else
+            changes.insert("*");
+    }
+
+    bool constantValue(AST::ASTExpression *expr, long long &res) {
+        if (auto number = dynamic_cast<AST::ASTIntNumber *>(expr)) {
+            res = number->getValue();
+            return true;
+        }
+        auto unary = dynamic_cast<AST::ASTUnaryOperator *>(expr);
+        if (!unary || (unary->getOperator() != AST::ASTUnaryOperator::MINUS &&
+                       unary->getOperator() != AST::ASTUnaryOperator::PLUS) || !constantValue(unary->getValue(), res))
+            return false;
+        if (unary->getOperator() == AST::ASTUnaryOperator::MINUS)
+            res = -res;
+        return true;
+    }
+
+    bool isVar(AST::ASTExpression *expr, const std::string &name) {
+        auto var = dynamic_cast<AST::ASTVar *>(expr);
+        return var && var->getName() == name;
+    }
+}
+
+void AST::ASTNode::collectChanges(std::set<std::string> &, std::size_t &size) {
+    ++size;
+}
+
+void AST::ASTBinaryOperator::collectChanges(std::set<std::string> &changes, std::size_t &size) {
+    ++size;
+    left->collectChanges(changes, size);
+    right->collectChanges(changes, size);
+}
+
+void AST::ASTUnaryOperator::collectChanges(std::set<std::string> &changes, std::size_t &size) {
+    ++size;
+    if (op == PREINC || op == PREDEC || op == POSTINC || op == POSTDEC || op == REFER)
+        changedBy(value.get(), changes);
+    value->collectChanges(changes, size);
+}
+
+void AST::ASTFunctionCall::collectChanges(std::set<std::string> &changes, std::size_t &size) {
+    ++size;
+    changes.insert("*");
+    name->collectChanges(changes, size);
+    for (auto &i: arg)
+        i->collectChanges(changes, size);
+}
+
+void AST::ASTMemberAccess::collectChanges(std::set<std::string> &changes, std::size_t &size) {
+    ++size;
+    name->collectChanges(changes, size);
+}
+
+void AST::ASTStruct::collectChanges(std::set<std::string> &changes, std::size_t &size) {
+    ++size;
+    for (auto &i: values)
+        i.second->collectChanges(changes, size);
+}
+
+void AST::ASTDeclaration::collectChanges(std::set<std::string> &changes, std::size_t &size) {
+    ++size;
+    for (auto &i: name)
+        changes.insert(i);
+    for (auto &i: value)
+        i->collectChanges(changes, size);
+    for (auto &i: dispatchedDeclarations)
+        i->collectChanges(changes, size);
+}
+
+void AST::ASTVarDeclaration::collectChanges(std::set<std::string> &changes, std::size_t &size) {
+    ASTDeclaration::collectChanges(changes, size);
+    if (function_dispatch)
+        function_dispatch->collectChanges(changes, size);
+}
+
+void AST::ASTBlock::collectChanges(std::set<std::string> &changes, std::size_t &size) {
+    for (auto &i: statements)
+        i->collectChanges(changes, size);
+}
+
+void AST::ASTReturn::collectChanges(std::set<std::string> &changes, std::size_t &size) {
+    ++size;
+    for (auto &i: return_value)
+        i->collectChanges(changes, size);
+}
+
+void AST::ASTSwitch::collectChanges(std::set<std::string> &changes, std::size_t &size) {
+    ++size;
+    expr->collectChanges(changes, size);
+    for (auto &[i, j]: cases) {
+        if (i)
+            i->collectChanges(changes, size);
+        j->collectChanges(changes, size);
+    }
+}
+
+void AST::ASTIf::collectChanges(std::set<std::string> &changes, std::size_t &size) {
+    ++size;
+    expr->collectChanges(changes, size);
+    if_clause->collectChanges(changes, size);
+    if (else_clause)
+        else_clause->collectChanges(changes, size);
+}
+
+void AST::ASTFor::collectChanges(std::set<std::string> &changes, std::size_t &size) {
+    ++size;
+    for (auto &i: init_clause)
+        i->collectChanges(changes, size);
+    if_clause->collectChanges(changes, size);
+    for (auto &i: iterate_clause)
+        i->collectChanges(changes, size);
+    body->collectChanges(changes, size);
+}
+
+void AST::ASTAssign::collectChanges(std::set<std::string> &changes, std::size_t &size) {
+    ++size;
+    if (function_dispatch)
+        function_dispatch->collectChanges(changes, size);
+    for (auto &i: variable) {
+        changedBy(i.get(), changes);
+        i->collectChanges(changes, size);
+    }
+    for (auto &i: value)
+        i->collectChanges(changes, size);
+}
+
+void AST::ASTScan::collectChanges(std::set<std::string> &changes, std::size_t &size) {
+    ++size;
+    changes.insert("*");
+    expression->collectChanges(changes, size);
+}
+
+void AST::ASTPrint::collectChanges(std::set<std::string> &changes, std::size_t &size) {
+    ++size;
+    expression->collectChanges(changes, size);
+}
+
+void AST::ASTCast::collectChanges(std::set<std::string> &changes, std::size_t &size) {
+    ++size;
+    expr->collectChanges(changes, size);
+}
+
+long long AST::ASTFor::Induction::trips() {
+    if (!constant)
+        return -1;
+
+    // iterations, while the variable goes the distance by the steps
+    long long distance;
+    switch (condition->getOperator()) {
+        case IR::IRArithOp::LT:
+            distance = bound - init;
+            break;
+        case IR::IRArithOp::LE:
+            distance = bound - init + 1;
+            break;
+        case IR::IRArithOp::GT:
+            distance = bound - init;
+            break;
+        case IR::IRArithOp::GE:
+            distance = bound - init - 1;
+            break;
+        default:
+            distance = bound - init;
+            if (distance % step || distance / step < 0)
+                return -1;
+            return distance / step;
+    }
+
+    if (step < 0) {
+        distance = -distance;
+        return distance <= 0 ? 0 : (distance - step - 1) / -step;
+    }
+    return distance <= 0 ? 0 : (distance + step - 1) / step;
+}
+
+bool AST::ASTFor::findInduction(Induction &loop) {
+    if (init_clause.size() != 1 || iterate_clause.size() != 1)
+        return false;
+
+    // i := init
+    auto declaration = dynamic_cast<ASTVarDeclaration *>(init_clause[0].get());
+    if (!declaration || declaration->dispatcher || declaration->getNames().size() != 1 ||
+        declaration->getValues().size() != 1 || !dynamic_cast<IntType *>(declaration->getValues()[0]->typeOfNode))
+        return false;
+    loop.name = declaration->getNames()[0];
+
+    // i++, i--, i += step, i -= step
+    auto iterate = iterate_clause[0].get();
+    if (auto unary = dynamic_cast<ASTUnaryOperator *>(iterate); unary && isVar(unary->getValue(), loop.name)) {
+        if (unary->getOperator() == ASTUnaryOperator::PREINC || unary->getOperator() == ASTUnaryOperator::POSTINC)
+            loop.step = 1;
+        else if (unary->getOperator() == ASTUnaryOperator::PREDEC ||
+                 unary->getOperator() == ASTUnaryOperator::POSTDEC)
+            loop.step = -1;
+    } else if (auto assign = dynamic_cast<ASTAssign *>(iterate); assign && assign->getVariables().size() == 1 &&
+                                                                   assign->getValues().size() == 1 &&
+                                                                   isVar(assign->getVariables()[0].get(), loop.name) &&
+                                                                   constantValue(assign->getValues()[0].get(),
+                                                                                 loop.step)) {
+        if (assign->getType() == ASTAssign::MINUSASSIGN)
+            loop.step = -loop.step;
+        else if (assign->getType() != ASTAssign::PLUSASSIGN)
+            loop.step = 0;
+    }
+    if (!loop.step)
+        return false;
+
+    // i < bound, where the direction of the comparison agrees with the step
+    loop.condition = dynamic_cast<ASTBinaryOperator *>(if_clause.get());
+    if (!loop.condition || !isVar(loop.condition->getLeft(), loop.name))
+        return false;
+    switch (loop.condition->getOperator()) {
+        case IR::IRArithOp::LT:
+        case IR::IRArithOp::LE:
+            if (loop.step < 0)
+                return false;
+            break;
+        case IR::IRArithOp::GT:
+        case IR::IRArithOp::GE:
+            if (loop.step > 0)
+                return false;
+            break;
+        case IR::IRArithOp::NE:
+            break;
+        default:
+            return false;
+    }
+
+    // body has not to touch the variable, the bound is a constant or the variable, which is not changed
+    std::set<std::string> changes;
+    body->collectChanges(changes, loop.size);
+    if (changes.count(loop.name))
+        return false;
+    iterate_clause[0]->collectChanges(changes, loop.size);
+
+    auto bound = loop.condition->getRight();
+    if (constantValue(bound, loop.bound))
+        loop.constant = constantValue(declaration->getValues()[0].get(), loop.init);
+    else if (auto var = dynamic_cast<ASTVar *>(bound);
+            !var || var->getName() == loop.name || changes.count(var->getName()) || changes.count("*") ||
+            !dynamic_cast<IntType *>(var->typeOfNode))
+        return false;
+
+    return true;
+}
@@ -38,11 +38,31 @@ AST::ASTBinaryOperator::ASTBinaryOperator(std::unique_ptr<AST::ASTExpression> &&
     right = std::move(new_right);
 }
 
+AST::ASTExpression *AST::ASTBinaryOperator::getLeft() {
+    return left.get();
+}
+
+AST::ASTExpression *AST::ASTBinaryOperator::getRight() {
+    return right.get();
+}
+
+IR::IRArithOp::Operator AST::ASTBinaryOperator::getOperator() {
+    return op;
+}
+
 AST::ASTUnaryOperator::ASTUnaryOperator(std::unique_ptr<AST::ASTExpression> &&new_value, Operator new_op) {
     op = new_op;
     value = std::move(new_value);
 }
 
+AST::ASTUnaryOperator::Operator AST::ASTUnaryOperator::getOperator() {
+    return op;
+}
+
+AST::ASTExpression *AST::ASTUnaryOperator::getValue() {
+    return value.get();
+}
+
 AST::ASTFunctionCall::ASTFunctionCall(std::unique_ptr<AST::ASTExpression> &&new_name,
                                       std::vector<std::unique_ptr<AST::ASTExpression>> &new_args) {
     name = std::move(new_name);
@@ -68,6 +88,10 @@ AST::ASTIntNumber::ASTIntNumber(const int new_value) {
     value = new_value;
 }
 
+long long AST::ASTIntNumber::getValue() {
+    return value;
+}
+
 AST::ASTFloatNumber::ASTFloatNumber(const double new_value) {
     value = new_value;
 }
@@ -113,6 +137,14 @@ AST::ASTDeclaration::ASTDeclaration(std::vector<std::string> &&new_name, std::un
     type = std::move(new_type);
 }
 
+std::vector<std::string> &AST::ASTDeclaration::getNames() {
+    return name;
+}
+
+std::vector<std::unique_ptr<AST::ASTExpression>> &AST::ASTDeclaration::getValues() {
+    return value;
+}
+
 void AST::Program::setName(std::string new_name) {
     name = new_name;
 }
@@ -175,6 +207,18 @@ AST::ASTAssign::ASTAssign(std::vector<std::unique_ptr<AST::ASTExpression>> &&new
     type = new_type;
 }
 
+AST::ASTAssign::TypeOfAssign AST::ASTAssign::getType() {
+    return type;
+}
+
+std::vector<std::unique_ptr<AST::ASTExpression>> &AST::ASTAssign::getVariables() {
+    return variable;
+}
+
+std::vector<std::unique_ptr<AST::ASTExpression>> &AST::ASTAssign::getValues() {
+    return value;
+}
+
 void AST::ASTScan::addExpression(std::unique_ptr<AST::ASTExpression>&& new_expr) {
     expression = std::move(new_expr);
 }
@@ -187,6 +231,14 @@ void AST::Function::setName(std::string new_name) {
     name = new_name;
 }
 
+std::string AST::Function::getName() {
+    return name;
+}
+
+bool AST::Function::returnsValue() {
+    return typeOfNode && name_for_return.empty();
+}
+
 void AST::Function::addParam(std::vector<std::string> &&new_names, std::unique_ptr<ASTType> &&new_type) {
     params.emplace_back(std::move(new_names), std::move(new_type));
 }
@@ -221,4 +273,31 @@ void AST::Program::addTypeDecl(std::unique_ptr<ASTDeclaration> &&new_decl) {
 
 void AST::Program::addFunction(std::unique_ptr<Function> &&new_func) {
     functions.push_back(std::move(new_func));
-}
\ No newline at end of file
+}
+std::vector<std::unique_ptr<AST::Function>> &AST::Program::getFunctions() {
+    return functions;
+}
+
+void AST::Function::setDigests(std::uint64_t signature, std::uint64_t body_tokens) {
+    signature_digest = signature;
+    body_digest = body_tokens;
+}
+
+std::uint64_t AST::Function::getSignatureDigest() {
+    return signature_digest;
+}
+
+std::uint64_t AST::Function::getBodyDigest() {
+    return body_digest;
+}
+
+void AST::Program::addDigest(std::uint64_t digest) {
+    declarations.add(digest);
+}
+
+std::uint64_t AST::Program::getDigest() {
+    auto res = declarations;
+    for (auto &i: functions)
+        res.add(i->getSignatureDigest());
+    return res.value();
+}
@@ -1,5 +1,7 @@
 #include "lexer.h"
 
+#include <bit>
+
 const struct {
     char *slovo;
     Token symb;
@@ -326,6 +328,35 @@ Token Lexer::readNumber() {
 }
 
 Token Lexer::gettok() {
+    // clocks are read only, when the time is measured
+    double cpu = 0;
+    std::chrono::steady_clock::time_point wall;
+    if (measure) {
+        wall = std::chrono::steady_clock::now();
+        cpu = Profiler::threadTime();
+    }
+    auto res = nextToken();
+    if (measure) {
+        cpu_time += Profiler::threadTime() - cpu;
+        wall_time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall).count();
+    }
+    digest.add((std::uint64_t) res);
+    if (res == tok_identifier)
+        digest.add(m_IdentifierStr);
+    else if (res == tok_num_int)
+        digest.add((std::uint64_t) m_NumVal);
+    else if (res == tok_num_float)
+        digest.add(std::bit_cast<std::uint64_t>(m_DouVal));
+    return res;
+}
+
+std::uint64_t Lexer::takeDigest() {
+    auto res = digest.value();
+    digest = Hash();
+    return res;
+}
+
+Token Lexer::nextToken() {
     line_number += if_new_line_appear;
     if_new_line_appear = 0;
     switch (type_of_char()) {
@@ -339,7 +370,7 @@ Token Lexer::gettok() {
             return tok_newline;
         case WHITE_SPACE:
             cur_symb = inputSymbol();
-            return gettok();
+            return nextToken();
         case END:
             return tok_eof;
         case SPE_SYMB:
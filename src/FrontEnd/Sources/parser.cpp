@@ -12,7 +12,8 @@ void Parser::matchAndGoNext(Token tok) {
     cur_tok = lexer.gettok();
 }
 
-Parser::Parser(std::string name) {
+Parser::Parser(std::string name, Profiler *new_profiler) : profiler(new_profiler) {
+    lexer.measureTime(profiler);
     lexer.InitInput(name);
     cur_tok = lexer.gettok();
 }
@@ -34,6 +35,8 @@ std::unique_ptr<AST::Program> Parser::parse() {
         switch (cur_tok) {
             // function
             case tok_func: {
+                // the function is hashed by itself
+                lexer.takeDigest();
                 auto tmp = parseFunction();
                 program->addFunction(std::move(tmp));
                 break;
@@ -41,20 +44,27 @@ std::unique_ptr<AST::Program> Parser::parse() {
                 // declaration
 
             case tok_type: {
+                lexer.takeDigest();
                 matchAndGoNext(tok_type);
                 for (auto &i: parseDeclarationBlock(std::bind(&Parser::parseTypeDeclarationLine, this)))
                     program->addTypeDecl(std::move(i));
+                program->addDigest(lexer.takeDigest());
                 break;
             }
             case tok_const: {
+                lexer.takeDigest();
                 matchAndGoNext(tok_const);
                 for (auto &i: parseDeclarationBlock(std::bind(&Parser::parseConstDeclarationLine, this)))
                     program->addVarDecl(std::move(i));
+                program->addDigest(lexer.takeDigest());
                 break;
             }
             case tok_var: {
+                lexer.takeDigest();
                 matchAndGoNext(tok_var);
                 for (auto &i: parseDeclarationBlock(std::bind(&Parser::parseVarDeclarationLine, this)))
+                    program->addVarDecl(std::move(i));
+                program->addDigest(lexer.takeDigest());
                 break;
             }
             default:
@@ -69,6 +79,8 @@ std::unique_ptr<AST::Program> Parser::parse() {
 
     checkForSeparatorAndSkip();
     match(tok_eof);
+    if (profiler)
+        profiler->add("lexing", lexer.getWallTime(), lexer.getCpuTime());
     return program;
 }
 
@@ -862,10 +874,12 @@ std::unique_ptr<AST::Function> Parser::parseFunction() {
 
     //parameters and return types
     parseFuncSignature(res);
+    auto signature = lexer.takeDigest();
 
     //body of a function
     auto body = parseBlock();
     res->setBody(std::move(body));
+    res->setDigests(signature, lexer.takeDigest());
 
     return res;
 
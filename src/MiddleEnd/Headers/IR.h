@@ -7,12 +7,29 @@
 #include <map>
 #include <set>
 #include <stack>
+#include <climits>
+#include <optional>
 
 #include "types.h"
+#include "MemoryReport.h"
 #include "T86Inst.h"
 
 namespace IR {
 
+    /**
+     * Interval [min, max] of the values, which an integer result can have
+     */
+    struct Range {
+        long long min = LLONG_MIN, max = LLONG_MAX;
+
+        bool isConstant() const;
+
+        bool nonNegative() const;
+
+        // does every value fit into the signed integer of the bits
+        bool fits(int) const;
+    };
+
     /**
      * Basic class of the IR instruction
      */
@@ -22,6 +39,10 @@ namespace IR {
 
         virtual ~Value() = default;
 
+        static void *operator new(std::size_t size) { return MemoryReport::allocate<Value>(size, MemoryReport::IR); }
+
+        static void operator delete(void *object) { MemoryReport::release(object); }
+
         // saves what instructions have this one by its child
         void addUse(Value *);
 
@@ -31,10 +52,25 @@ namespace IR {
         virtual void generateT86(T86::Context &) = 0;
 
         // returns the operand, in which the result is stored
-        virtual std::unique_ptr<T86::Operand> getOperand(T86::Context &);
+        virtual T86::Operand getOperand(T86::Context &);
+
+        // returns the memory operand, which points to the result (as an address) plus offset
+        virtual T86::Operand getMemory(T86::Context &, long long = 0);
+
+        // is the result a floating point number, so it is kept in the float registers
+        virtual bool isFloat();
+
+        // values, which the instruction reads
+        virtual std::vector<Value *> getOperands();
+
+        // register (general or float by the type of the result), in which the result is kept
+        T86::Operand getRegister(T86::Context &);
 
         unsigned long long inner_number;
 
+        // values of the result, found by the range analysis
+        Range range;
+
     private:
         std::vector<Value *> uses;
     };
@@ -52,6 +88,9 @@ namespace IR {
         // fulfill with the value
         virtual void fillWithValue(unsigned long long) = 0;
 
+        // words of the value in the memory, from the first one
+        virtual void addWords(std::vector<T86::Operand> &) = 0;
+
     private:
     };
 
@@ -76,6 +115,10 @@ namespace IR {
         // tmp registers for an IR code
         long long counter = 0;
 
+        // counted loops are unrolled by the factor (1 -- not unrolled), while the unrolled body fits
+        // into the budget of the AST nodes
+        std::size_t unroll_factor = 1, unroll_budget = 64;
+
         // name of the return structure as an argument
         std::string name_if_return_become_arg;
 
@@ -138,6 +181,9 @@ namespace IR {
         // by the type get basic type, to store in it
         std::unique_ptr<Const> getBasicValue(Type *);
 
+        // stores zeros into all the fields of the structure at the address
+        void zeroStructure(Value *, StructType *);
+
     private:
         // set a function, in which it is going to build instruction
         IR::IRFunc *where_build;
@@ -165,7 +211,7 @@ namespace IR {
 
         void generateT86(T86::Context &) override;
 
-        std::unique_ptr<T86::Operand> getOperand(T86::Context &) override;
+        T86::Operand getOperand(T86::Context &) override;
 
         void print(std::ostream &) override;
 
@@ -173,6 +219,10 @@ namespace IR {
 
         void fillWithValue(unsigned long long) override{};
 
+        void addWords(std::vector<T86::Operand> &) override;
+
+        long long getValue() const;
+
     private:
         long long value = 0;
     };
@@ -183,9 +233,13 @@ namespace IR {
 
         void addValue(double);
 
+        double getValue() const;
+
         void generateT86(T86::Context &) override;
 
-        std::unique_ptr<T86::Operand> getOperand(T86::Context &) override;
+        T86::Operand getOperand(T86::Context &) override;
+
+        bool isFloat() override;
 
         void print(std::ostream &) override;
 
@@ -193,6 +247,8 @@ namespace IR {
 
         void fillWithValue(unsigned long long) override{};
 
+        void addWords(std::vector<T86::Operand> &) override;
+
     private:
         double value = 0;
     };
@@ -203,7 +259,7 @@ namespace IR {
 
         void generateT86(T86::Context &) override;
 
-        std::unique_ptr<T86::Operand> getOperand(T86::Context &) override;
+        T86::Operand getOperand(T86::Context &) override;
 
         void print(std::ostream &) override;
 
@@ -211,6 +267,8 @@ namespace IR {
 
         void fillWithValue(unsigned long long) override{};
 
+        void addWords(std::vector<T86::Operand> &) override;
+
     private:
     };
 
@@ -224,7 +282,7 @@ namespace IR {
 
         void generateT86(T86::Context &) override;
 
-        std::unique_ptr<T86::Operand> getOperand(T86::Context &) override;
+        T86::Operand getOperand(T86::Context &) override;
 
         void print(std::ostream &) override;
 
@@ -232,6 +290,8 @@ namespace IR {
 
         void fillWithValue(unsigned long long) override{};
 
+        void addWords(std::vector<T86::Operand> &) override;
+
     private:
         //it may be const, or might be a value
         std::vector<std::pair<std::unique_ptr<Const>, Value *>> basic_values;
@@ -281,13 +341,31 @@ namespace IR {
 
         void setTypeOfResult(Type *);
 
+        Operator getOperator();
+
+        Value *getLeft();
+
+        Value *getRight();
+
+        Type *getTypeOfResult();
+
         void generateT86(T86::Context &) override;
 
-        std::unique_ptr<T86::Operand> getOperand(T86::Context &) override;
+        T86::Operand getOperand(T86::Context &) override;
+
+        bool isFloat() override;
+
+        std::vector<Value *> getOperands() override;
 
         void print(std::ostream &) override;
 
     private:
+        // integer result is known, so it is not computed. The users take it as an immediate
+        bool folded();
+
+        // multiplication, division and remainder by a power of two as the shifts and masks.
+        // Returns false, if the operands do not allow it
+        bool strengthReduce(T86::Context &);
 
         Operator op;
 
@@ -316,14 +394,22 @@ namespace IR {
 
         Value *getPointer();
 
+        void setTypeOfResult(Type *);
+
+        std::vector<Value *> getOperands() override;
+
         void print(std::ostream &) override;
 
         void generateT86(T86::Context &) override;
 
-        std::unique_ptr<T86::Operand> getOperand(T86::Context &) override;
+        T86::Operand getOperand(T86::Context &) override;
+
+        bool isFloat() override;
 
     private:
         Value *where;
+
+        Type *result_type = nullptr;
     };
 
     class IRStore : public Instruction {
@@ -334,6 +420,12 @@ namespace IR {
 
         void addStoreWhat(Value *);
 
+        Value *getStoreWhere();
+
+        Value *getStoreWhat();
+
+        std::vector<Value *> getOperands() override;
+
         void print(std::ostream &) override;
 
         void generateT86(T86::Context &) override;
@@ -354,39 +446,64 @@ namespace IR {
 
         void addBasicValue(std::unique_ptr<Const> &&);
 
+        // nullptr, if the value is set by the user
+        Const *getBasicValue();
+
+        // the object lives at the address of the value instead of the frame
+        void placeAt(Value *);
+
+        bool isPlaced();
+
         void print(std::ostream &) override;
 
         void generateT86(T86::Context &) override;
 
-        std::unique_ptr<T86::Operand> getOperand(T86::Context &) override;
+        T86::Operand getOperand(T86::Context &) override;
+
+        T86::Operand getMemory(T86::Context &, long long = 0) override;
 
     private:
         Type *type;
 
         std::unique_ptr<Const> basicValue;
 
+        Value *placed = nullptr;
+
         // how many bytes its upper, then Basic Pointer
         long long place_on_stack = -1;
 
     };
 
+    /**
+     * Global variable. It lives in the .data segment with the value known before the run (zero, if there is
+     * none). Dynamic values are stored into it by the function, which runs before main
+     */
     class IRGlobal : public Instruction {
     public:
         using Instruction::Instruction;
 
-        void addValue(Value *);
+        void addBasicValue(std::unique_ptr<Const> &&);
 
         void addType(Type *);
 
         void print(std::ostream &) override;
 
+        // places the global into the .data segment
         void generateT86(T86::Context &) override;
 
-        std::unique_ptr<T86::Operand> getOperand(T86::Context &) override;
+        // address of the first word
+        long long getAddress();
+
+        T86::Operand getOperand(T86::Context &) override;
+
+        T86::Operand getMemory(T86::Context &, long long = 0) override;
 
     private:
         Type *type;
-        Value *value;
+
+        std::unique_ptr<Const> basicValue;
+
+        long long address = 0;
     };
 
     class IRBranch : public Instruction {
@@ -399,6 +516,15 @@ namespace IR {
 
         void addBrNTaken(Value *);
 
+        // nullptr for the unconditional branch
+        Value *getCond();
+
+        Value *getBrTaken();
+
+        Value *getBrNTaken();
+
+        std::vector<Value *> getOperands() override;
+
         void print(std::ostream &) override;
 
         void generateT86(T86::Context &) override;
@@ -415,12 +541,17 @@ namespace IR {
 
         void addRetVal(Value *);
 
+        // nullptr, if nothing is returned
+        Value *getRetVal();
+
+        std::vector<Value *> getOperands() override;
+
         void print(std::ostream &) override;
 
         void generateT86(T86::Context &) override;
 
     private:
-        Value *res;
+        Value *res = nullptr;
     };
 
     class IRCall : public Instruction {
@@ -433,15 +564,27 @@ namespace IR {
 
         void addArg(Value *);
 
+        void setTypeOfResult(Type *);
+
+        std::string getFunctionName();
+
+        void setArg(std::size_t, Value *);
+
+        std::vector<Value *> getOperands() override;
+
         void print(std::ostream &) override;
 
         void generateT86(T86::Context &) override;
 
-        std::unique_ptr<T86::Operand> getOperand(T86::Context &) override;
+        T86::Operand getOperand(T86::Context &) override;
+
+        bool isFloat() override;
 
     private:
         IRFunc *function;
 
+        Type *result_type = nullptr;
+
         std::string name_of_function;
 
         std::vector<Value *> arguments;
@@ -458,11 +601,15 @@ namespace IR {
 
         void addCallWhat(int);
 
+        std::vector<Value *> getOperands() override;
+
         void print(std::ostream &) override;
 
         void generateT86(T86::Context &) override;
 
-        std::unique_ptr<T86::Operand> getOperand(T86::Context &) override;
+        T86::Operand getOperand(T86::Context &) override;
+
+        T86::Operand getMemory(T86::Context &, long long = 0) override;
 
     private:
         Value *where;
@@ -470,6 +617,9 @@ namespace IR {
         // which arguments by the order it calls
         int what;
 
+        // member of a global has the absolute address
+        std::optional<long long> address;
+
         // type of the structure, from which it calls the member
         StructType* typeOfWhere;
 
@@ -485,11 +635,13 @@ namespace IR {
 
         void addCallWhat(int);
 
+        std::vector<Value *> getOperands() override;
+
         void print(std::ostream &) override;
 
         void generateT86(T86::Context &) override;
 
-        std::unique_ptr<T86::Operand> getOperand(T86::Context &) override;
+        T86::Operand getOperand(T86::Context &) override;
 
     private:
         Value *where;
@@ -508,15 +660,31 @@ namespace IR {
 
         void addTypeToFrom(Type *, Type *);
 
+        Value *getExpr();
+
+        Type *getTypeTo();
+
+        Type *getTypeFrom();
+
+        std::vector<Value *> getOperands() override;
+
         void print(std::ostream &) override;
 
         void generateT86(T86::Context &) override;
 
-        std::unique_ptr<T86::Operand> getOperand(T86::Context &) override;
+        T86::Operand getOperand(T86::Context &) override;
+
+        bool isFloat() override;
 
     private:
+        // the value is the same in the both types, so the users take the operand of the expression
+        bool changesNothing();
+
         Value *expr;
         Type *to, *from;
+
+        // nothing is generated, the operand of the expression is used
+        bool forwarded = false;
     };
 
 /**
@@ -533,6 +701,12 @@ namespace IR {
 
         void addSize(long long);
 
+        Value *getCopyFrom();
+
+        Value *getCopyTo();
+
+        std::vector<Value *> getOperands() override;
+
         void print(std::ostream &) override;
 
         void generateT86(T86::Context &) override;
@@ -550,6 +724,8 @@ namespace IR {
 
         void addLink(Value*);
 
+        std::vector<Value *> getOperands() override;
+
         void print(std::ostream &) override;
 
         void generateT86(T86::Context &) override;
@@ -565,6 +741,8 @@ namespace IR {
 
         void addValue(Value*);
 
+        std::vector<Value *> getOperands() override;
+
         void print(std::ostream &) override;
 
         void generateT86(T86::Context &) override;
@@ -582,11 +760,18 @@ namespace IR {
 
         void addOrder(long long = 0);
 
+        // argument is passed in the register of the calling convention
+        void addRegister(long long);
+
+        Type *getType();
+
         void print(std::ostream &) override;
 
         void generateT86(T86::Context &) override;
 
-        std::unique_ptr<T86::Operand> getOperand(T86::Context &) override;
+        T86::Operand getOperand(T86::Context &) override;
+
+        bool isFloat() override;
 
         long long size();
 
@@ -595,6 +780,9 @@ namespace IR {
 
         long long order_of_arg = 0;
 
+        // -1 if passed through the stack
+        long long register_of_arg = -1;
+
     };
 
     class IRFunc : public Value {
@@ -605,6 +793,10 @@ namespace IR {
 
         void addArg(std::unique_ptr<IRFuncArg> &&);
 
+        std::vector<std::unique_ptr<IRFuncArg>> *getLinkToArgs();
+
+        std::vector<std::unique_ptr<Value>> *getLinkToAllocas();
+
         void addAlloca(std::unique_ptr<Value> &&);
 
         void addInstToBody(std::unique_ptr<Value> &&);
@@ -613,6 +805,9 @@ namespace IR {
 
         std::string getName();
 
+        // does function return a value through the stack
+        bool returnsValue();
+
         void setSpaceForAlloca(long long);
 
         std::vector<std::unique_ptr<Value>> *getLinkToBody();
@@ -640,14 +835,30 @@ namespace IR {
     public:
         using Value::Value;
 
+        // function, which stores the dynamic values into the globals before main. The name is not an identifier
+        inline static const std::string init_function = ".init";
+
         void addGlobDecl(std::unique_ptr<Value> &&);
 
         void addFunc(std::unique_ptr<Value> &&);
 
+        std::vector<std::unique_ptr<Value>> *getLinkToFunctions();
+
+        // frees the functions, which are already compiled. The globals stay
+        void releaseFunctions();
+
         void print(std::ostream &) override;
 
+        void printFunctions(std::ostream &);
+
         void generateT86(T86::Context &) override;
 
+        // globals in the .data segment and the code, which starts the program
+        void generateEntry(T86::Context &);
+
+        // code of the functions, which are in the program now
+        void generateFunctions(T86::Context &);
+
     private:
         std::vector<std::unique_ptr<Value>> globalDecl;
 
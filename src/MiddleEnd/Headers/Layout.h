@@ -0,0 +1,37 @@
+#ifndef COMPILER_LAYOUT_H
+#define COMPILER_LAYOUT_H
+
+#include <vector>
+
+#include "IR.h"
+
+namespace IR {
+
+    /**
+     * Placement of the basic blocks of the functions. Unreachable blocks are removed, the rest is put
+     * in chains, so the likely successor of each block follows it. The instruction selection then drops
+     * the jump to it or inverts the condition of the branch
+     */
+    class BlockLayout {
+    public:
+        void run(IRProgram &);
+
+    private:
+        /**
+         * Instructions [begin, end) of the body of the function
+         */
+        struct Block {
+            std::size_t begin = 0, end = 0;
+
+            // the likely one first
+            std::vector<std::size_t> successors;
+
+            // block does not end by a branch or a return, so the next one has to follow it
+            bool falls_through = false;
+        };
+
+        void layoutFunction(IRFunc &);
+    };
+}
+
+#endif //COMPILER_LAYOUT_H
@@ -0,0 +1,86 @@
+#ifndef COMPILER_MODREF_H
+#define COMPILER_MODREF_H
+
+#include <map>
+#include <set>
+#include <vector>
+#include <algorithm>
+
+#include "IR.h"
+
+namespace IR {
+
+    /**
+     * Copies of the structures around the calls. Returned structure is written by the callee into the place,
+     * which address the caller passes as the hidden last argument:
+     *  - the local variable, which every return copies out, is placed right at that address (NRVO)
+     *  - the caller, which copies the result from its temporary into a local object, passes the address of
+     *    the object instead, if nothing else can see the object during the call
+     * Structure passed by value is copied by the caller into a temporary and its address is passed. If the
+     * called function only reads the structure and the original cannot change during the call (its address
+     * is never taken), the copy is dropped and the address of the original is passed instead
+     */
+    class ModRefAnalysis {
+    public:
+        void run(IRProgram &);
+
+        // the program comes function after function. Calls of the functions, which came before, use what
+        // is known about their arguments, the others are left as they are
+        void runStreamed(IRFunc &);
+
+        // arguments, which are only read, of each function, which has been seen
+        const std::map<std::string, std::vector<bool>> &getSummaries();
+
+        // what is known about the function, which has been compiled before
+        void addSummary(const std::string &, const std::vector<bool> &);
+
+    private:
+        // instructions of the function, which read the value
+        using Users = std::map<Value *, std::vector<Value *>>;
+
+        static Users findUsers(IRFunc &);
+
+        // does the function only read the structure, which address is passed as the argument
+        bool readOnly(IRFunc &, std::size_t);
+
+        // memory at the address is only read and the address does not leave
+        static bool onlyRead(Value *, Users &);
+
+        // local object is only accessed directly and its address does not leave
+        static bool staysLocal(Value *, Users &);
+
+        // address of the object and of all its members
+        static void collectMembers(Value *, Users &, std::vector<Value *> &);
+
+        // places the returned variable at the address of the result
+        static void placeResult(IRFunc &);
+
+        // root variable of the member, nullptr if it is not a local object
+        static IRAlloca *rootOf(Value *);
+
+        // result of the call is written right into the object, into which it was copied
+        static void forwardResults(IRFunc &, std::set<Value *> &);
+
+        // number of the arguments of the called function, -1 if it is not known
+        long long argumentsOf(const std::string &);
+
+        // does the called function only read the structure passed as the argument
+        bool readOnly(const std::string &, std::size_t);
+
+        // passes the read-only structures without the copy
+        void passOriginals(IRFunc &, std::set<Value *> &);
+
+        void runFunction(IRFunc &);
+
+        std::map<std::string, IRFunc *> functions;
+
+        std::map<IRFunc *, Users> users;
+
+        std::map<std::pair<IRFunc *, std::size_t>, bool> read_only;
+
+        // arguments, which are only read, of the functions, which are already freed
+        std::map<std::string, std::vector<bool>> summaries;
+    };
+}
+
+#endif //COMPILER_MODREF_H
@@ -0,0 +1,72 @@
+#ifndef COMPILER_RANGE_H
+#define COMPILER_RANGE_H
+
+#include <map>
+#include <set>
+#include <algorithm>
+
+#include "IR.h"
+
+namespace IR {
+
+    /**
+     * Interval analysis of the integer values of the program. Local variables, whose address is not taken,
+     * collect the values stored into them, the arguments collect the values of all the calls and the calls
+     * get the values of all the returns of the function. Found intervals are kept in Value::range. The
+     * instruction selection then drops the casts, which change nothing, takes the decided comparisons as
+     * the constants and picks the cheaper forms of the instructions
+     */
+    class RangeAnalysis {
+    public:
+        void run(IRProgram &);
+
+        // the program holds only a part of the functions, which can be called from the other parts
+        void runPart(IRProgram &);
+
+    private:
+        // value, which is not reached yet
+        static Range empty();
+
+        static bool isEmpty(const Range &);
+
+        static Range full();
+
+        static Range join(const Range &, const Range &);
+
+        // adds the values into the place, which collects them. Returns true on the change
+        bool collect(Range &, const Range &);
+
+        // local variables, which are only loaded and stored
+        void findSlots(IRFunc &);
+
+        // passes the values of the arguments into the called functions, which are known
+        void findCalls(IRFunc &);
+
+        // one pass over the function. Returns true, if anything has changed
+        bool analyseFunction(IRFunc &);
+
+        Range transfer(Value *);
+
+        Range arithmetic(IRArithOp *);
+
+        Range compare(IRArithOp *);
+
+        std::map<std::string, IRFunc *> functions;
+
+        // values stored into the local variables
+        std::map<Value *, Range> slots;
+
+        // values returned by the functions
+        std::map<IRFunc *, Range> results;
+
+        // functions, whose arguments are known only from the calls
+        std::set<IRFunc *> called;
+
+        bool part = false;
+
+        // after a few rounds the growing bounds jump right to the limits, so the analysis ends
+        std::size_t round = 0;
+    };
+}
+
+#endif //COMPILER_RANGE_H
@@ -1,5 +1,19 @@
 #include "IR.h"
 
+bool IR::Range::isConstant() const {
+    return min == max;
+}
+
+bool IR::Range::nonNegative() const {
+    return min >= 0 && min <= max;
+}
+
+bool IR::Range::fits(int bits) const {
+    if (bits >= 64)
+        return true;
+    return min >= -(1LL << (bits - 1)) && max < (1LL << (bits - 1));
+}
+
 IR::Value::Value(long long &counter) {
     inner_number = counter++;
 }
@@ -8,6 +22,14 @@ void IR::Value::addUse(Value *use) {
     uses.emplace_back(use);
 }
 
+bool IR::Value::isFloat() {
+    return false;
+}
+
+std::vector<IR::Value *> IR::Value::getOperands() {
+    return {};
+}
+
 IR::Context::Context() {
     goDeeper();
 }
@@ -127,10 +149,41 @@ std::unique_ptr<IR::Const> IR::Context::getBasicValue(Type *type) {
     return nullptr;
 }
 
+void IR::Context::zeroStructure(Value *pointer, StructType *structure) {
+    auto fields = structure->getFields();
+    for (std::size_t i = 0; i < fields.size(); ++i) {
+        auto member_access = std::make_unique<IR::IRMembCall>(counter);
+        member_access->addCallWhere(pointer);
+        member_access->addCallWhat(i);
+        member_access->addTypeWhere(structure);
+        auto pointer_to_member = buildInstruction(std::move(member_access));
+
+        if (auto inner = dynamic_cast<StructType *>(fields[i].second)) {
+            zeroStructure(pointer_to_member, inner);
+            continue;
+        }
+
+        Value *zero;
+        if (dynamic_cast<FloatType *>(fields[i].second))
+            zero = buildInstruction(std::make_unique<IR::DoubleConst>(counter));
+        else
+            zero = buildInstruction(std::make_unique<IR::IntConst>(counter));
+
+        auto store = std::make_unique<IR::IRStore>(counter);
+        store->addStoreWhat(zero);
+        store->addStoreWhere(pointer_to_member);
+        buildInstruction(std::move(store));
+    }
+}
+
 void IR::IntConst::addValue(long long val) {
     value = val;
 }
 
+long long IR::IntConst::getValue() const {
+    return value;
+}
+
 void IR::IntConst::print(std::ostream &oss) {
     oss << "   " << "%" << inner_number << " = create int constant " << value << std::endl;
 }
@@ -143,6 +196,10 @@ void IR::DoubleConst::addValue(double val) {
     value = val;
 }
 
+double IR::DoubleConst::getValue() const {
+    return value;
+}
+
 void IR::DoubleConst::print(std::ostream &oss) {
     oss << "   " << "%" << inner_number << " = create double constant " << value << std::endl;
 }
@@ -151,6 +208,10 @@ std::string IR::DoubleConst::toString() {
     return std::to_string(value);
 }
 
+bool IR::DoubleConst::isFloat() {
+    return true;
+}
+
 void IR::Nullptr::print(std::ostream &oss) {
     oss << "   " << "%" << inner_number << " = create nullptr" << std::endl;
 }
@@ -213,6 +274,30 @@ void IR::IRArithOp::setTypeOfResult(Type *new_type) {
     result_type = new_type;
 }
 
+IR::IRArithOp::Operator IR::IRArithOp::getOperator() {
+    return op;
+}
+
+IR::Value *IR::IRArithOp::getLeft() {
+    return left;
+}
+
+IR::Value *IR::IRArithOp::getRight() {
+    return right;
+}
+
+Type *IR::IRArithOp::getTypeOfResult() {
+    return result_type;
+}
+
+bool IR::IRArithOp::isFloat() {
+    return dynamic_cast<FloatType *>(result_type);
+}
+
+std::vector<IR::Value *> IR::IRArithOp::getOperands() {
+    return {left, right};
+}
+
 void IR::IRArithOp::print(std::ostream &oss) {
     std::string name_of_operation = operator_to_str.find(op)->second;
     if (dynamic_cast<FloatType *>(result_type))
@@ -233,6 +318,18 @@ IR::Value *IR::IRLoad::getPointer() {
     return where;
 }
 
+void IR::IRLoad::setTypeOfResult(Type *new_type) {
+    result_type = new_type;
+}
+
+bool IR::IRLoad::isFloat() {
+    return dynamic_cast<FloatType *>(result_type);
+}
+
+std::vector<IR::Value *> IR::IRLoad::getOperands() {
+    return {where};
+}
+
 void IR::IRLoad::print(std::ostream &oss) {
     oss << "   " << "%" << inner_number << " = load from:%" << where->inner_number << std::endl;
 }
@@ -245,6 +342,18 @@ void IR::IRStore::addStoreWhat(Value *new_link) {
     what = new_link;
 }
 
+IR::Value *IR::IRStore::getStoreWhere() {
+    return where;
+}
+
+IR::Value *IR::IRStore::getStoreWhat() {
+    return what;
+}
+
+std::vector<IR::Value *> IR::IRStore::getOperands() {
+    return {where, what};
+}
+
 void IR::IRStore::print(std::ostream &oss) {
     oss << "   " << "store - what: %" << what->inner_number << " ; where: %" << where->inner_number << std::endl;
 }
@@ -261,26 +370,47 @@ void IR::IRAlloca::addBasicValue(std::unique_ptr<Const> &&new_value) {
     basicValue = std::move(new_value);
 }
 
+IR::Const *IR::IRAlloca::getBasicValue() {
+    return basicValue.get();
+}
+
+void IR::IRAlloca::placeAt(Value *address) {
+    placed = address;
+}
+
+bool IR::IRAlloca::isPlaced() {
+    return placed;
+}
+
 void IR::IRAlloca::print(std::ostream &oss) {
     oss << "   " << "%" << inner_number << " = alloca '" << type->toString() << "'; ";
+    if (placed)
+        oss << "placed at %" << placed->inner_number << "; ";
     if (basicValue)
         oss << "default value is " << basicValue->toString() << std::endl;
     else
         oss << "no default is set, cause some value set by user" << std::endl;
 }
 
-void IR::IRGlobal::addValue(Value *n_value) {
-    value = n_value;
+void IR::IRGlobal::addBasicValue(std::unique_ptr<Const> &&new_value) {
+    basicValue = std::move(new_value);
 }
 
 void IR::IRGlobal::addType(Type *new_type) {
     type = new_type;
 }
 
+long long IR::IRGlobal::getAddress() {
+    return address;
+}
+
 void IR::IRGlobal::print(std::ostream &oss) {
-    // TODO basic value
-    oss << "%" << inner_number << " = global '" << type->toString() << "' ; value is " << std::endl << std::endl
-        << std::endl;
+    oss << "%" << inner_number << " = global '" << type->toString() << "' ; value is ";
+    if (basicValue)
+        oss << basicValue->toString();
+    else
+        oss << "stored by " << IRProgram::init_function;
+    oss << std::endl << std::endl << std::endl;
 }
 
 void IR::IRBranch::addCond(Value *new_val) {
@@ -295,7 +425,31 @@ void IR::IRBranch::addBrNTaken(Value *Ntaken_label) {
     brNT = Ntaken_label;
 }
 
+IR::Value *IR::IRBranch::getCond() {
+    return result;
+}
+
+IR::Value *IR::IRBranch::getBrTaken() {
+    return brT;
+}
+
+IR::Value *IR::IRBranch::getBrNTaken() {
+    return brNT;
+}
+
+std::vector<IR::Value *> IR::IRBranch::getOperands() {
+    if (result)
+        return {result};
+    return {};
+}
+
 void IR::IRBranch::print(std::ostream &oss) {
+    // condition decided by the range analysis -- the other side may be already removed
+    if (result && result->range.isConstant()) {
+        oss << "   " << "jmp %" << (result->range.min == 1 ? brT : brNT)->inner_number << " ; decided cond: %"
+            << result->inner_number << std::endl;
+        return;
+    }
     if (result) {
         oss << "   " << "cond jmp Cond: %" << result->inner_number << "; If true: %" << brT->inner_number
             << "; false: %" << brNT->inner_number << std::endl;
@@ -308,6 +462,16 @@ void IR::IRRet::addRetVal(Value *new_val) {
     res = new_val;
 }
 
+IR::Value *IR::IRRet::getRetVal() {
+    return res;
+}
+
+std::vector<IR::Value *> IR::IRRet::getOperands() {
+    if (res)
+        return {res};
+    return {};
+}
+
 void IR::IRRet::print(std::ostream &oss) {
     if (res)
         oss << "   " << "ret %" << res->inner_number << std::endl;
@@ -327,6 +491,26 @@ void IR::IRCall::addArg(Value *new_arg) {
     arguments.emplace_back(new_arg);
 }
 
+void IR::IRCall::setTypeOfResult(Type *new_type) {
+    result_type = new_type;
+}
+
+std::string IR::IRCall::getFunctionName() {
+    return name_of_function;
+}
+
+void IR::IRCall::setArg(std::size_t place, Value *new_arg) {
+    arguments[place] = new_arg;
+}
+
+std::vector<IR::Value *> IR::IRCall::getOperands() {
+    return arguments;
+}
+
+bool IR::IRCall::isFloat() {
+    return dynamic_cast<FloatType *>(result_type);
+}
+
 void IR::IRCall::print(std::ostream &oss) {
     oss << "   " << "%" << inner_number << " = call %" << name_of_function << " with arguments : (";
     for (auto i = 0; i < arguments.size(); ++i) {
@@ -350,6 +534,10 @@ void IR::IRMembCall::addCallWhat(int value) {
     what = value;
 }
 
+std::vector<IR::Value *> IR::IRMembCall::getOperands() {
+    return {where};
+}
+
 void IR::IRMembCall::print(std::ostream &oss) {
     oss << "   " << "%" << inner_number << " = get member - from: %" << where->inner_number << "; which: %"
         << std::to_string(what) << std::endl;
@@ -367,6 +555,10 @@ void IR::IRElemCall::addCallWhat(int value) {
     what = value;
 }
 
+std::vector<IR::Value *> IR::IRElemCall::getOperands() {
+    return {where};
+}
+
 void IR::IRElemCall::print(std::ostream &oss) {
     oss << "   " << "%" << inner_number << " = get element - from: %" << where->inner_number << "; which: %"
         << std::to_string(what) << std::endl;
@@ -381,6 +573,26 @@ void IR::IRCast::addTypeToFrom(Type *new_to, Type *new_from) {
     from = new_from;
 }
 
+IR::Value *IR::IRCast::getExpr() {
+    return expr;
+}
+
+Type *IR::IRCast::getTypeTo() {
+    return to;
+}
+
+Type *IR::IRCast::getTypeFrom() {
+    return from;
+}
+
+std::vector<IR::Value *> IR::IRCast::getOperands() {
+    return {expr};
+}
+
+bool IR::IRCast::isFloat() {
+    return dynamic_cast<FloatType *>(to);
+}
+
 void IR::IRCast::print(std::ostream &oss) {
     oss << "   " << "%" << inner_number << " = cast what: %" << expr->inner_number << "; to: '" << to->toString() << "'"
         << std::endl;
@@ -398,6 +610,18 @@ void IR::IRMemCopy::addSize(long long new_size) {
     size = new_size;
 }
 
+IR::Value *IR::IRMemCopy::getCopyFrom() {
+    return from;
+}
+
+IR::Value *IR::IRMemCopy::getCopyTo() {
+    return to;
+}
+
+std::vector<IR::Value *> IR::IRMemCopy::getOperands() {
+    return {from, to};
+}
+
 void IR::IRMemCopy::print(std::ostream &oss) {
     oss << "   " << "copy content from: %" << from->inner_number << " ; to: %"
         << to->inner_number << " with size of " << size * 4 << " bytes" << std::endl;
@@ -407,6 +631,10 @@ void IR::IRScan::addLink(Value* new_link){
     link = new_link;
 }
 
+std::vector<IR::Value *> IR::IRScan::getOperands() {
+    return {link};
+}
+
 void IR::IRScan::print(std::ostream &oss) {
     oss << "   " << "scan : into %" << link->inner_number << std::endl;
 }
@@ -415,6 +643,10 @@ void IR::IRPrint::addValue(Value* new_value){
     value = new_value;
 }
 
+std::vector<IR::Value *> IR::IRPrint::getOperands() {
+    return {value};
+}
+
 void IR::IRPrint::print(std::ostream &oss) {
     oss << "   " << "print : %" << value->inner_number << std::endl;
 }
@@ -427,10 +659,22 @@ void IR::IRFuncArg::addOrder(long long num) {
     order_of_arg = num;
 }
 
+void IR::IRFuncArg::addRegister(long long num) {
+    register_of_arg = num;
+}
+
+Type *IR::IRFuncArg::getType() {
+    return type;
+}
+
 void IR::IRFuncArg::print(std::ostream &oss) {
     oss << "'" << type->toString() << "' %" << inner_number;
 }
 
+bool IR::IRFuncArg::isFloat() {
+    return dynamic_cast<FloatType *>(type);
+}
+
 long long IR::IRFuncArg::size() {
     return type->size();
 }
@@ -439,10 +683,18 @@ void IR::IRFunc::addReturnType(Type *new_type) {
     return_type = new_type;
 }
 
+bool IR::IRFunc::returnsValue() {
+    return return_type != nullptr;
+}
+
 void IR::IRFunc::addArg(std::unique_ptr<IRFuncArg> &&new_arg) {
     arguments.emplace_back(std::move(new_arg));
 }
 
+std::vector<std::unique_ptr<IR::IRFuncArg>> *IR::IRFunc::getLinkToArgs() {
+    return &arguments;
+}
+
 void IR::IRFunc::addAlloca(std::unique_ptr<Value> &&new_alloca) {
     allocas.emplace_back(std::move(new_alloca));
 }
@@ -467,6 +719,10 @@ std::vector<std::unique_ptr<IR::Value>> *IR::IRFunc::getLinkToBody() {
     return &body;
 }
 
+std::vector<std::unique_ptr<IR::Value>> *IR::IRFunc::getLinkToAllocas() {
+    return &allocas;
+}
+
 void IR::IRFunc::print(std::ostream &oss) {
     oss << "function %" << name << "; arguments: (";
     for (auto i = 0; i < arguments.size(); ++i) {
@@ -498,10 +754,22 @@ void IR::IRProgram::addFunc(std::unique_ptr<Value> &&new_function) {
     functions.emplace_back(std::move(new_function));
 }
 
+std::vector<std::unique_ptr<IR::Value>> *IR::IRProgram::getLinkToFunctions() {
+    return &functions;
+}
+
+void IR::IRProgram::releaseFunctions() {
+    functions.clear();
+}
+
 void IR::IRProgram::print(std::ostream &oss) {
     for (auto &i: globalDecl)
         i->print(oss);
 
+    printFunctions(oss);
+}
+
+void IR::IRProgram::printFunctions(std::ostream &oss) {
     for (auto &i: functions)
         i->print(oss);
 }
@@ -1,42 +1,103 @@
 #include "IR.h"
 
-std::unique_ptr<T86::Operand> IR::Value::getOperand(T86::Context &) {
+#include <algorithm>
+
+T86::Operand IR::Value::getOperand(T86::Context &) {
     throw std::invalid_argument("Never should happened");
 }
 
+// register of the calling convention
+static T86::Operand conventionRegister(bool floating, std::size_t number) {
+    if (floating)
+        return T86::FRegister(number);
+    return T86::Register(number);
+}
+
+T86::Operand IR::Value::getRegister(T86::Context &ctx) {
+    if (isFloat())
+        return T86::FRegister(inner_number - ctx.offset_of_function);
+    return T86::Register(inner_number - ctx.offset_of_function);
+}
+
+T86::Operand IR::Value::getMemory(T86::Context &ctx, long long offset) {
+    auto address = getOperand(ctx);
+    // address kept in the memory is loaded first
+    if (!address.isRegister()) {
+        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, getRegister(ctx), address));
+        address = getRegister(ctx);
+    }
+    return T86::Memory(T86::Register(address.getNumber(), address.getOffset() + offset));
+}
+
 void IR::IntConst::generateT86(T86::Context &ctx) {
 
 }
 
-std::unique_ptr<T86::Operand> IR::IntConst::getOperand(T86::Context &) {
-    return std::make_unique<T86::IntImmediate>(value);
+T86::Operand IR::IntConst::getOperand(T86::Context &) {
+    return T86::IntImmediate(value);
+}
+
+void IR::IntConst::addWords(std::vector<T86::Operand> &words) {
+    words.emplace_back(T86::IntImmediate(value));
 }
 
 void IR::DoubleConst::generateT86(T86::Context &ctx) {
 
 }
 
-std::unique_ptr<T86::Operand> IR::DoubleConst::getOperand(T86::Context &) {
-    return std::make_unique<T86::DoubleImmediate>(value);
+T86::Operand IR::DoubleConst::getOperand(T86::Context &) {
+    return T86::DoubleImmediate(value);
+}
+
+void IR::DoubleConst::addWords(std::vector<T86::Operand> &words) {
+    words.emplace_back(T86::DoubleImmediate(value));
 }
 
 void IR::Nullptr::generateT86(T86::Context &ctx) {
 
 }
 
-std::unique_ptr<T86::Operand> IR::Nullptr::getOperand(T86::Context &) {
-    return std::make_unique<T86::IntImmediate>();
+T86::Operand IR::Nullptr::getOperand(T86::Context &) {
+    return T86::IntImmediate();
+}
+
+void IR::Nullptr::addWords(std::vector<T86::Operand> &words) {
+    words.emplace_back(T86::IntImmediate());
 }
 
 void IR::StructConst::generateT86(T86::Context &) {
 
 }
 
-std::unique_ptr<T86::Operand> IR::StructConst::getOperand(T86::Context &) {
+T86::Operand IR::StructConst::getOperand(T86::Context &) {
+
+}
 
+void IR::StructConst::addWords(std::vector<T86::Operand> &words) {
+    for (auto &[constant, value]: basic_values) {
+        if (!constant)
+            throw std::invalid_argument("ERROR. Value of the structure is not known before the run.");
+        constant->addWords(words);
+    }
 }
 
 void IR::IRArithOp::generateT86(T86::Context &ctx) {
+    if (folded())
+        return;
+
+    if ((op == MUL || op == DIV || op == MOD) && !dynamic_cast<FloatType *>(result_type) && strengthReduce(ctx))
+        return;
+
+    // T86 has no remainder. x % y = x - (x / y) * y
+    if (op == MOD) {
+        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, getRegister(ctx), left->getOperand(ctx)));
+        ctx.addInstruction(T86::Instruction(T86::Instruction::IDIV, getRegister(ctx), right->getOperand(ctx)));
+        ctx.addInstruction(T86::Instruction(T86::Instruction::IMUL, getRegister(ctx), right->getOperand(ctx)));
+        ctx.addInstruction(T86::Instruction(T86::Instruction::NEG, getRegister(ctx)));
+        ctx.addInstruction(T86::Instruction(T86::Instruction::ADD, getRegister(ctx), left->getOperand(ctx)));
+        return;
+    }
+
     if (op == PLUS || op == MINUS || op == MUL || op == DIV || op == BINAND || op == AND || op == BINOR || op == OR ||
         op == XOR) {
         T86::Instruction::Opcode opcode_for_instruction;
@@ -58,9 +119,9 @@ void IR::IRArithOp::generateT86(T86::Context &ctx) {
             else if (op == MINUS)
                 opcode_for_instruction = T86::Instruction::SUB;
             else if (op == MUL)
-                opcode_for_instruction = T86::Instruction::MUL;
+                opcode_for_instruction = T86::Instruction::IMUL;
             else
-                opcode_for_instruction = T86::Instruction::DIV;
+                opcode_for_instruction = T86::Instruction::IDIV;
         }
         if (op == BINAND || op == AND)
             opcode_for_instruction = T86::Instruction::AND;
@@ -69,25 +130,35 @@ void IR::IRArithOp::generateT86(T86::Context &ctx) {
         if (op == XOR)
             opcode_for_instruction = T86::Instruction::XOR;
 
-        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV,
-                                            std::make_unique<T86::Register>(inner_number - ctx.offset_of_function),
-                                            left->getOperand(ctx)));
-        ctx.addInstruction(T86::Instruction(opcode_for_instruction,
-                                            std::make_unique<T86::Register>(inner_number - ctx.offset_of_function),
-                                            right->getOperand(ctx)));
+        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, getRegister(ctx), left->getOperand(ctx)));
+        ctx.addInstruction(T86::Instruction(opcode_for_instruction, getRegister(ctx), right->getOperand(ctx)));
         return;
     }
 
 
     //EQ, NE, GT, GE, LT, LE,
 
+    // result is bool, so the type of the compare is by the operands
+    bool float_compare = left->isFloat() || right->isFloat();
     T86::Instruction::Opcode type_of_compare;
-    if (dynamic_cast<FloatType *>(result_type))
+    if (float_compare)
         type_of_compare = T86::Instruction::FCMP;
     else
         type_of_compare = T86::Instruction::CMP;
 
-    ctx.addInstruction(T86::Instruction(type_of_compare, left->getOperand(ctx), right->getOperand(ctx)));
+    // T86 compares a register with something. Float register with the same number is free
+    auto compared = left->getOperand(ctx);
+    if (!compared.isRegister() && !compared.isFRegister()) {
+        T86::Operand tmp;
+        if (float_compare)
+            tmp = T86::FRegister(inner_number - ctx.offset_of_function);
+        else
+            tmp = T86::Register(inner_number - ctx.offset_of_function);
+        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, tmp, compared));
+        compared = tmp;
+    }
+
+    ctx.addInstruction(T86::Instruction(type_of_compare, compared, right->getOperand(ctx)));
 
 
     T86::Instruction::Opcode opcode_of_compare;
@@ -105,27 +176,108 @@ void IR::IRArithOp::generateT86(T86::Context &ctx) {
         opcode_of_compare = T86::Instruction::JLE;
     // Jump to true
     ctx.addInstruction(T86::Instruction(opcode_of_compare,
-                                        std::make_unique<T86::IntImmediate>(ctx.getNumberOfInstructions() + 3)));
+                                        T86::IntImmediate(ctx.getNumberOfInstructions() + 3)));
 
     // if false
 
     ctx.addInstruction(T86::Instruction(T86::Instruction::MOV,
-                                        std::make_unique<T86::Register>(inner_number - ctx.offset_of_function),
-                                        std::make_unique<T86::IntImmediate>(0)));
+                                        T86::Register(inner_number - ctx.offset_of_function),
+                                        T86::IntImmediate(0)));
 
     ctx.addInstruction(T86::Instruction(T86::Instruction::JMP,
-                                        std::make_unique<T86::IntImmediate>(ctx.getNumberOfInstructions() + 2)));
+                                        T86::IntImmediate(ctx.getNumberOfInstructions() + 2)));
 
     // if true.
 
     ctx.addInstruction(T86::Instruction(T86::Instruction::MOV,
-                                        std::make_unique<T86::Register>(inner_number - ctx.offset_of_function),
-                                        std::make_unique<T86::IntImmediate>(1)));
+                                        T86::Register(inner_number - ctx.offset_of_function),
+                                        T86::IntImmediate(1)));
+
+}
+
+bool IR::IRArithOp::strengthReduce(T86::Context &ctx) {
+    auto constant = dynamic_cast<IntConst *>(right);
+    auto value = left;
+    // multiplication commutes, so the constant may be on the left
+    if (!constant && op == MUL) {
+        constant = dynamic_cast<IntConst *>(left);
+        value = right;
+    }
+    if (!constant)
+        return false;
+
+    bool negative = constant->getValue() < 0;
+    auto magnitude = static_cast<unsigned long long>(constant->getValue());
+    if (negative)
+        magnitude = 0 - magnitude;
+    if (magnitude == 0 || (magnitude & (magnitude - 1)))
+        return false;
+
+    long long shift = 0;
+    while ((1ULL << shift) != magnitude)
+        ++shift;
+    auto mask = static_cast<long long>(magnitude - 1);
+
+    ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, getRegister(ctx), value->getOperand(ctx)));
+
+    if (op == MUL) {
+        if (shift)
+            ctx.addInstruction(T86::Instruction(T86::Instruction::LSH, getRegister(ctx),
+                                                T86::IntImmediate(shift)));
+        if (negative)
+            ctx.addInstruction(T86::Instruction(T86::Instruction::NEG, getRegister(ctx)));
+        return true;
+    }
+
+    if (op == DIV) {
+        // RSH rounds down, division rounds toward zero. Negative values are biased by 2^k - 1 first
+        if (shift && value->range.nonNegative())
+            ctx.addInstruction(T86::Instruction(T86::Instruction::RSH, getRegister(ctx),
+                                                T86::IntImmediate(shift)));
+        else if (shift) {
+            ctx.addInstruction(T86::Instruction(T86::Instruction::CMP, getRegister(ctx),
+                                                T86::IntImmediate(0)));
+            ctx.addInstruction(T86::Instruction(T86::Instruction::JGE, T86::IntImmediate(
+                    ctx.getNumberOfInstructions() + 2)));
+            ctx.addInstruction(T86::Instruction(T86::Instruction::ADD, getRegister(ctx),
+                                                T86::IntImmediate(mask)));
+            ctx.addInstruction(T86::Instruction(T86::Instruction::RSH, getRegister(ctx),
+                                                T86::IntImmediate(shift)));
+        }
+        if (negative)
+            ctx.addInstruction(T86::Instruction(T86::Instruction::NEG, getRegister(ctx)));
+        return true;
+    }
+
+    // remainder takes the sign of the dividend: x % 2^k = x & (2^k - 1), or -(-x & (2^k - 1)) for negative x
+    if (value->range.nonNegative()) {
+        ctx.addInstruction(T86::Instruction(T86::Instruction::AND, getRegister(ctx),
+                                            T86::IntImmediate(mask)));
+        return true;
+    }
+    ctx.addInstruction(T86::Instruction(T86::Instruction::CMP, getRegister(ctx),
+                                        T86::IntImmediate(0)));
+    ctx.addInstruction(T86::Instruction(T86::Instruction::JL, T86::IntImmediate(
+            ctx.getNumberOfInstructions() + 3)));
+    ctx.addInstruction(T86::Instruction(T86::Instruction::AND, getRegister(ctx),
+                                        T86::IntImmediate(mask)));
+    ctx.addInstruction(T86::Instruction(T86::Instruction::JMP, T86::IntImmediate(
+            ctx.getNumberOfInstructions() + 4)));
+    ctx.addInstruction(T86::Instruction(T86::Instruction::NEG, getRegister(ctx)));
+    ctx.addInstruction(T86::Instruction(T86::Instruction::AND, getRegister(ctx),
+                                        T86::IntImmediate(mask)));
+    ctx.addInstruction(T86::Instruction(T86::Instruction::NEG, getRegister(ctx)));
+    return true;
+}
 
+bool IR::IRArithOp::folded() {
+    return !dynamic_cast<FloatType *>(result_type) && range.isConstant();
 }
 
-std::unique_ptr<T86::Operand> IR::IRArithOp::getOperand(T86::Context &ctx) {
-    return std::make_unique<T86::Register>(inner_number - ctx.offset_of_function);
+T86::Operand IR::IRArithOp::getOperand(T86::Context &ctx) {
+    if (folded())
+        return T86::IntImmediate(range.min);
+    return getRegister(ctx);
 }
 
 void IR::IRLabel::generateT86(T86::Context &ctx) {
@@ -133,225 +285,371 @@ void IR::IRLabel::generateT86(T86::Context &ctx) {
 }
 
 void IR::IRLoad::generateT86(T86::Context &ctx) {
-    ctx.addInstruction(T86::Instruction(T86::Instruction::MOV,
-                                        std::make_unique<T86::Register>(inner_number - ctx.offset_of_function),
-                                        std::make_unique<T86::Memory>(where->getOperand(ctx))));
+    // only the one value is ever stored there
+    if (!isFloat() && range.isConstant())
+        return;
+    ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, getRegister(ctx), where->getMemory(ctx)));
 }
 
-std::unique_ptr<T86::Operand> IR::IRLoad::getOperand(T86::Context &ctx) {
-    return std::make_unique<T86::Register>(inner_number - ctx.offset_of_function);
+T86::Operand IR::IRLoad::getOperand(T86::Context &ctx) {
+    if (!isFloat() && range.isConstant())
+        return T86::IntImmediate(range.min);
+    return getRegister(ctx);
 }
 
 void IR::IRStore::generateT86(T86::Context &ctx) {
     // TODO something more smarter
     // T86 does not support MOV [], []
 
-    if (dynamic_cast<T86::Memory*>(what->getOperand(ctx).get())) {
-        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, std::make_unique<T86::Register>(
-                what->inner_number - ctx.offset_of_function), what->getOperand(ctx)));
+    auto value = what->getOperand(ctx);
+    if (value.isMemory()) {
+        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, what->getRegister(ctx), value));
 
-        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, std::make_unique<T86::Memory>(where->getOperand(ctx)),
-                std::make_unique<T86::Register>(what->inner_number - ctx.offset_of_function)));
+        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, where->getMemory(ctx), what->getRegister(ctx)));
 
         return;
     }
-    ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, std::make_unique<T86::Memory>(where->getOperand(ctx)),
-            what->getOperand(ctx)));
+    ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, where->getMemory(ctx), value));
 }
 
 void IR::IRAlloca::generateT86(T86::Context &ctx) {
+    if (placed)
+        return;
 
     place_on_stack = -ctx.getCurrentPlaceOnStack(type->size());
+    ctx.addFrameObject(place_on_stack, type->size());
 }
 
-std::unique_ptr<T86::Operand> IR::IRAlloca::getOperand(T86::Context &ctx) {
-    ctx.addInstruction(T86::Instruction(T86::Instruction::MOV,std::make_unique<T86::Register>(inner_number - ctx.offset_of_function), std::make_unique<T86::Register>(T86::Register::BP)));
-    ctx.addInstruction(T86::Instruction(T86::Instruction::ADD,std::make_unique<T86::Register>(inner_number - ctx.offset_of_function), std::make_unique<T86::IntImmediate>(place_on_stack)));
-    return std::make_unique<T86::Register>(inner_number - ctx.offset_of_function);
+T86::Operand IR::IRAlloca::getOperand(T86::Context &ctx) {
+    if (placed) {
+        auto address = placed->getOperand(ctx);
+        if (address.isRegister())
+            return address;
+        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, T86::Register(
+                inner_number - ctx.offset_of_function), address));
+        return T86::Register(inner_number - ctx.offset_of_function);
+    }
+
+    // address is needed as a value
+    ctx.addInstruction(T86::Instruction(T86::Instruction::LEA,T86::Register(inner_number - ctx.offset_of_function), getMemory(ctx)));
+    return T86::Register(inner_number - ctx.offset_of_function);
+
+}
 
+T86::Operand IR::IRAlloca::getMemory(T86::Context &ctx, long long offset) {
+    if (placed) {
+        auto address = getOperand(ctx);
+        return T86::Memory(T86::Register(address.getNumber(), address.getOffset() + offset));
+    }
+    return T86::Memory(T86::Register(T86::Register::BP, place_on_stack + offset));
 }
 
 void IR::IRGlobal::generateT86(T86::Context &ctx) {
+    std::vector<T86::Operand> words;
+    if (basicValue)
+        basicValue->addWords(words);
+    words.resize(type->size(), T86::IntImmediate());
 
+    // words of the object go down from the first one
+    std::reverse(words.begin(), words.end());
+    address = ctx.addData(words) + (long long) words.size() - 1;
 }
 
-std::unique_ptr<T86::Operand> IR::IRGlobal::getOperand(T86::Context &) {
+T86::Operand IR::IRGlobal::getOperand(T86::Context &) {
+    return T86::IntImmediate(address);
+}
 
+T86::Operand IR::IRGlobal::getMemory(T86::Context &, long long offset) {
+    return T86::Memory(T86::IntImmediate(address + offset));
 }
 
 void IR::IRBranch::generateT86(T86::Context &ctx) {
-    auto place_to_jmp_if_true = std::make_unique<T86::IntImmediate>();
-    auto place_to_jmp_if_false = std::make_unique<T86::IntImmediate>();
+    // condition decided by the range analysis is just a jump
+    if (result && result->range.isConstant()) {
+        ctx.addJumpToLabel(result->range.min == 1 ? brT->inner_number : brNT->inner_number);
+        ctx.addInstruction(T86::Instruction(T86::Instruction::JMP, T86::IntImmediate()));
+        return;
+    }
 
-    ctx.addJumpToLabel(brT->inner_number, place_to_jmp_if_true.get());
     if (!result) {
-        ctx.addInstruction(T86::Instruction(T86::Instruction::JMP, std::move(place_to_jmp_if_true)));
+        ctx.addJumpToLabel(brT->inner_number);
+        ctx.addInstruction(T86::Instruction(T86::Instruction::JMP, T86::IntImmediate()));
         return;
     }
 
-    ctx.addJumpToLabel(brNT->inner_number, place_to_jmp_if_false.get());
     ctx.addInstruction(
-            T86::Instruction(T86::Instruction::CMP, result->getOperand(ctx), std::make_unique<T86::IntImmediate>(1)));
+            T86::Instruction(T86::Instruction::CMP, result->getOperand(ctx), T86::IntImmediate(1)));
 
-    ctx.addInstruction(T86::Instruction(T86::Instruction::JE, std::move(place_to_jmp_if_true)));
-    ctx.addInstruction(T86::Instruction(T86::Instruction::JMP, std::move(place_to_jmp_if_false)));
+    ctx.addJumpToLabel(brT->inner_number);
+    ctx.addInstruction(T86::Instruction(T86::Instruction::JE, T86::IntImmediate()));
+    ctx.addJumpToLabel(brNT->inner_number);
+    ctx.addInstruction(T86::Instruction(T86::Instruction::JMP, T86::IntImmediate()));
 
 }
 
 void IR::IRRet::generateT86(T86::Context &ctx) {
+    auto &function = ctx.currentFunction();
+
     // if it returns something -- return
-    if (res)
-        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, std::make_unique<T86::Memory>(
-                                                    std::make_unique<T86::Register>(T86::Register::BP, 2 + ctx.allocated_space_for_arguments)),
+    if (res && (function.register_result || function.float_register_result))
+        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV,
+                                            conventionRegister(function.float_register_result, 0),
+                                            res->getOperand(ctx)));
+    else if (res)
+        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, T86::Memory(
+                                                    T86::Register(T86::Register::BP, 2 + ctx.allocated_space_for_arguments)),
                                             res->getOperand(ctx)));
 
     // remove from stack all allocated variables
-    ctx.addInstruction(T86::Instruction(T86::Instruction::ADD, std::make_unique<T86::Register>(T86::Register::SP),
-                                        std::make_unique<T86::IntImmediate>(ctx.allocated_space_for_variables)));
+    ctx.addInstruction(T86::Instruction(T86::Instruction::ADD, T86::Register(T86::Register::SP),
+                                        T86::IntImmediate(ctx.allocated_space_for_variables)));
 
 
-    ctx.addInstruction(T86::Instruction(T86::Instruction::POP, std::make_unique<T86::Register>(T86::Register::BP)));
+    ctx.addInstruction(T86::Instruction(T86::Instruction::POP, T86::Register(T86::Register::BP)));
     ctx.addInstruction(T86::Instruction(T86::Instruction::RET));
 }
 
 void IR::IRCall::generateT86(T86::Context &ctx) {
+    bool returns_value = ctx.doesFunctionReturn(name_of_function);
+    auto &convention = ctx.getProgram().getCallingConvention();
+    bool in_registers = convention.registers || convention.float_registers;
+
+    // the first arguments of each file go in the registers, the rest through the stack
+    std::vector<long long> register_of_arg(arguments.size(), -1);
+    std::size_t used_registers = 0, used_float_registers = 0, pushed = 0;
+    for (std::size_t i = 0; i < arguments.size(); ++i) {
+        if (arguments[i]->isFloat() && used_float_registers < convention.float_registers)
+            register_of_arg[i] = used_float_registers++;
+        else if (!arguments[i]->isFloat() && used_registers < convention.registers)
+            register_of_arg[i] = used_registers++;
+        else
+            pushed++;
+    }
+
     // reserv space to return value(1) if return value exists
-    ctx.addInstruction(T86::Instruction(T86::Instruction::SUB, std::make_unique<T86::Register>(T86::Register::SP),
-                                        std::make_unique<T86::IntImmediate>(1)));
+    if (returns_value && !in_registers)
+        ctx.addInstruction(T86::Instruction(T86::Instruction::SUB, T86::Register(T86::Register::SP),
+                                            T86::IntImmediate(1)));
+
+    // push arguments to the stack. Floats are pushed from the float registers
+    for (long long i = arguments.size() - 1; i >= 0; --i) {
+        if (register_of_arg[i] >= 0)
+            continue;
+        auto argument = arguments[i]->getOperand(ctx);
+        if (!arguments[i]->isFloat()) {
+            ctx.addInstruction(T86::Instruction(T86::Instruction::PUSH, argument));
+            continue;
+        }
 
-    // push arguments to the stack
-    for (long long i = arguments.size() - 1; i >= 0; --i)
-        ctx.addInstruction(T86::Instruction(T86::Instruction::PUSH, arguments[i]->getOperand(ctx)));
+        if (!argument.isFRegister()) {
+            ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, T86::FRegister(
+                    inner_number - ctx.offset_of_function), argument));
+            argument = T86::FRegister(inner_number - ctx.offset_of_function);
+        }
+        ctx.addInstruction(T86::Instruction(T86::Instruction::FPUSH, argument));
+    }
 
-    auto place_to_jump_func = std::make_unique<T86::IntImmediate>();
-    ctx.addFunctionCall(name_of_function, place_to_jump_func.get());
+    // registers are filled just before the call, so nothing is evaluated between
+    for (std::size_t i = 0; i < arguments.size(); ++i)
+        if (register_of_arg[i] >= 0)
+            ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, conventionRegister(arguments[i]->isFloat(),
+                                                                                          register_of_arg[i]),
+                                                arguments[i]->getOperand(ctx)));
 
     // jump
-    ctx.addInstruction(T86::Instruction(T86::Instruction::CALL, std::move(place_to_jump_func)));
+    ctx.addFunctionCall(name_of_function);
+    ctx.addInstruction(T86::Instruction(T86::Instruction::CALL, T86::IntImmediate()));
 
 
     // delete all arguments from stack
-    ctx.addInstruction(T86::Instruction(T86::Instruction::ADD, std::make_unique<T86::Register>(T86::Register::SP),
-                                        std::make_unique<T86::IntImmediate>(arguments.size())));
+    if (!in_registers || pushed)
+        ctx.addInstruction(T86::Instruction(T86::Instruction::ADD, T86::Register(T86::Register::SP),
+                                            T86::IntImmediate(pushed)));
 
-    // pop return value
-    ctx.addInstruction(T86::Instruction(T86::Instruction::POP,
-                                        std::make_unique<T86::Register>(inner_number - ctx.offset_of_function)));
+    // take the return value
+    if (returns_value && in_registers)
+        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, getRegister(ctx),
+                                            conventionRegister(isFloat(), 0)));
+    else if (returns_value)
+        ctx.addInstruction(T86::Instruction(isFloat() ? T86::Instruction::FPOP : T86::Instruction::POP,
+                                            getRegister(ctx)));
 
 }
 
-std::unique_ptr<T86::Operand> IR::IRCall::getOperand(T86::Context &ctx) {
-    return std::make_unique<T86::Register>(inner_number - ctx.offset_of_function);
+T86::Operand IR::IRCall::getOperand(T86::Context &ctx) {
+    return getRegister(ctx);
 }
 
 void IR::IRMembCall::generateT86(T86::Context &ctx) {
-    ctx.addInstruction(T86::Instruction(T86::Instruction::MOV,std::make_unique<T86::Register>(inner_number - ctx.offset_of_function),
-            where->getOperand(ctx)));
-
     // calc, place of the member
     long long off = 0;
     auto fields = typeOfWhere->getFields();
     for (auto i = 0; i < what; ++i)
         off += fields[i].second->size();
 
-    ctx.addInstruction(T86::Instruction(T86::Instruction::ADD,std::make_unique<T86::Register>(inner_number - ctx.offset_of_function),
-            std::make_unique<T86::IntImmediate>(-what)));
+    auto memory = where->getMemory(ctx, -off);
+    if (memory.isAbsolute()) {
+        address = memory.getOffset();
+        return;
+    }
+    ctx.addInstruction(T86::Instruction(T86::Instruction::LEA,T86::Register(inner_number - ctx.offset_of_function),
+            memory));
+}
+
+T86::Operand IR::IRMembCall::getOperand(T86::Context &ctx) {
+    if (address)
+        return T86::IntImmediate(*address);
+    return T86::Register(inner_number - ctx.offset_of_function);
 }
 
-std::unique_ptr<T86::Operand> IR::IRMembCall::getOperand(T86::Context &ctx) {
-    return std::make_unique<T86::Register>(inner_number - ctx.offset_of_function);
+T86::Operand IR::IRMembCall::getMemory(T86::Context &ctx, long long offset) {
+    if (address)
+        return T86::Memory(T86::IntImmediate(*address + offset));
+    return Value::getMemory(ctx, offset);
 }
 
 void IR::IRElemCall::generateT86(T86::Context &ctx) {
-    ctx.addInstruction(T86::Instruction(T86::Instruction::MOV,std::make_unique<T86::Register>(inner_number - ctx.offset_of_function),
-                                        where->getOperand(ctx)));
     long long off = typeOfElem->size() * what;
-    ctx.addInstruction(T86::Instruction(T86::Instruction::ADD,std::make_unique<T86::Register>(inner_number - ctx.offset_of_function),
-            std::make_unique<T86::IntImmediate>(-what)));
+    ctx.addInstruction(T86::Instruction(T86::Instruction::LEA,T86::Register(inner_number - ctx.offset_of_function),
+            where->getMemory(ctx, -what)));
+}
+
+T86::Operand IR::IRElemCall::getOperand(T86::Context &ctx) {
+    return T86::Register(inner_number - ctx.offset_of_function);
 }
 
-std::unique_ptr<T86::Operand> IR::IRElemCall::getOperand(T86::Context &ctx) {
-    return std::make_unique<T86::Register>(inner_number - ctx.offset_of_function);
+bool IR::IRCast::changesNothing() {
+    auto int_to = dynamic_cast<IntType *>(to), int_from = dynamic_cast<IntType *>(from);
+    if (!int_to || !int_from)
+        return false;
+    return int_to->getBits() >= int_from->getBits() || expr->range.fits(int_to->getBits());
 }
 
 void IR::IRCast::generateT86(T86::Context &ctx) {
-    T86::Instruction::Opcode opcode_for_instruction;
-    if (dynamic_cast<IntType *>(from) && dynamic_cast<FloatType *>(to))
-        opcode_for_instruction = T86::Instruction::EXT;
-    if (dynamic_cast<FloatType *>(from) && dynamic_cast<IntType *>(to))
-        opcode_for_instruction = T86::Instruction::NRW;
+    auto value = expr->getOperand(ctx);
+    bool from_float = dynamic_cast<FloatType *>(from), to_float = dynamic_cast<FloatType *>(to);
+
+    // the register or the constant of the expression is taken by the users right away
+    if (changesNothing() && (value.isRegister() || value.isIntImmediate())) {
+        forwarded = true;
+        return;
+    }
+
+    // inside the same register file -- just copy
+    if (from_float == to_float) {
+        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, getRegister(ctx), value));
+        return;
+    }
 
-    ctx.addInstruction(T86::Instruction(opcode_for_instruction,
-                                        std::make_unique<T86::Register>(inner_number - ctx.offset_of_function),
-                                        expr->getOperand(ctx)));
+    // EXT and NRW convert only between the registers. Register with the same number in the other file is free
+    if (from_float && !value.isFRegister()) {
+        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, T86::FRegister(
+                inner_number - ctx.offset_of_function), value));
+        value = T86::FRegister(inner_number - ctx.offset_of_function);
+    }
+    if (!from_float && !value.isRegister()) {
+        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, T86::Register(
+                inner_number - ctx.offset_of_function), value));
+        value = T86::Register(inner_number - ctx.offset_of_function);
+    }
+
+    ctx.addInstruction(T86::Instruction(to_float ? T86::Instruction::EXT : T86::Instruction::NRW, getRegister(ctx),
+                                        value));
 }
 
-std::unique_ptr<T86::Operand> IR::IRCast::getOperand(T86::Context &ctx) {
-    return std::make_unique<T86::Register>(inner_number - ctx.offset_of_function);
+T86::Operand IR::IRCast::getOperand(T86::Context &ctx) {
+    if (forwarded)
+        return expr->getOperand(ctx);
+    return getRegister(ctx);
 }
 
 void IR::IRMemCopy::generateT86(T86::Context &ctx) {
     for (auto i = 0; i < size; ++i) {
         ctx.addInstruction(T86::Instruction(T86::Instruction::MOV,
-                                            std::make_unique<T86::Register>(inner_number - ctx.offset_of_function),
-                                                    from->getOperand(ctx)));
-
-        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV,
-                                            std::make_unique<T86::Register>(inner_number - ctx.offset_of_function),
-                                            std::make_unique<T86::Memory>(std::make_unique<T86::Register>(inner_number - ctx.offset_of_function,-i))));
-
-        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV,
-                                            std::make_unique<T86::Register>(0),
-                                            to->getOperand(ctx)));
-        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV,std::make_unique<T86::Memory>(std::make_unique<T86::Register>(0,-i)),std::make_unique<T86::Register>(inner_number - ctx.offset_of_function)));
+                                            T86::Register(inner_number - ctx.offset_of_function),
+                                            from->getMemory(ctx, -i)));
+        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, to->getMemory(ctx, -i),
+                                            T86::Register(inner_number - ctx.offset_of_function)));
     }
 }
 
 void IR::IRScan::generateT86(T86::Context &ctx) {
     ctx.addInstruction(T86::Instruction(T86::Instruction::GETCHAR,
-                                        std::make_unique<T86::Register>(inner_number - ctx.offset_of_function)));
+                                        T86::Register(inner_number - ctx.offset_of_function)));
     ctx.addInstruction(T86::Instruction(T86::Instruction::MOV,
-                                        std::make_unique<T86::Memory>(link->getOperand(ctx)),
-                                        std::make_unique<T86::Register>(inner_number - ctx.offset_of_function)));
+                                        link->getMemory(ctx),
+                                        T86::Register(inner_number - ctx.offset_of_function)));
 }
 
 void IR::IRPrint::generateT86(T86::Context &ctx) {
-    ctx.addInstruction(T86::Instruction(T86::Instruction::MOV,std::make_unique<T86::Register>(inner_number - ctx.offset_of_function),value->getOperand(ctx)));
-    ctx.addInstruction(T86::Instruction(T86::Instruction::PUTNUM,std::make_unique<T86::Register>(inner_number - ctx.offset_of_function)));
+    ctx.addInstruction(T86::Instruction(T86::Instruction::MOV,T86::Register(inner_number - ctx.offset_of_function),value->getOperand(ctx)));
+    ctx.addInstruction(T86::Instruction(T86::Instruction::PUTNUM,T86::Register(inner_number - ctx.offset_of_function)));
 }
 
 void IR::IRFuncArg::generateT86(T86::Context &ctx) {
-    throw std::invalid_argument("Should not happen???");
+    // argument on the stack is read from its place
+    if (register_of_arg >= 0)
+        ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, getRegister(ctx),
+                                            conventionRegister(isFloat(), register_of_arg)));
 }
 
-std::unique_ptr<T86::Operand> IR::IRFuncArg::getOperand(T86::Context &ctx) {
-    return std::make_unique<T86::Memory>(std::make_unique<T86::Register>(T86::Register::BP, order_of_arg + 2));
+T86::Operand IR::IRFuncArg::getOperand(T86::Context &ctx) {
+    // copied from the argument register in the prologue
+    if (register_of_arg >= 0)
+        return getRegister(ctx);
+    return T86::Memory(T86::Register(T86::Register::BP, order_of_arg + 2));
 }
 
 void IR::IRFunc::generateT86(T86::Context &ctx) {
     // pre init for any function
     ctx.addFunctionPlace(this->name);
-    ctx.offset_of_function = inner_number;
+
+    // registers of the calling convention are not used by the values
+    auto &convention = ctx.getProgram().getCallingConvention();
+    ctx.offset_of_function = inner_number - (long long) convention.reserved();
 
     ctx.startFunction();
 
+    // the first arguments of each file are passed in the registers, the rest stays on the stack
+    auto &info = ctx.currentFunction();
+    long long stack_order = 0;
+    for (auto &i: arguments) {
+        auto &used = i->isFloat() ? info.float_register_arguments : info.register_arguments;
+        if (used < (i->isFloat() ? convention.float_registers : convention.registers))
+            i->addRegister(used++);
+        else {
+            i->addOrder(stack_order);
+            stack_order += i->size();
+        }
+    }
+    if (return_type && convention.reserved()) {
+        info.register_result = !dynamic_cast<FloatType *>(return_type);
+        info.float_register_result = !info.register_result;
+    }
+
     for(auto &i : arguments)
         ctx.allocated_space_for_arguments += i->size();
 
     for (auto &i : allocas)
-        ctx.allocated_space_for_variables += dynamic_cast<IRAlloca*>(i.get())->getType()->size();
+        if (!dynamic_cast<IRAlloca*>(i.get())->isPlaced())
+            ctx.allocated_space_for_variables += dynamic_cast<IRAlloca*>(i.get())->getType()->size();
 
 
     // push basic pointer of pr function
-    ctx.addInstruction(T86::Instruction(T86::Instruction::PUSH, std::make_unique<T86::Register>(T86::Register::BP)));
-    ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, std::make_unique<T86::Register>(T86::Register::BP),
-                                        std::make_unique<T86::Register>(T86::Register::SP)));
+    ctx.addInstruction(T86::Instruction(T86::Instruction::PUSH, T86::Register(T86::Register::BP)));
+    ctx.addInstruction(T86::Instruction(T86::Instruction::MOV, T86::Register(T86::Register::BP),
+                                        T86::Register(T86::Register::SP)));
 
 
     // allocate place for variables
-    if (!allocas.empty())
-        ctx.addInstruction(T86::Instruction(T86::Instruction::SUB, std::make_unique<T86::Register>(T86::Register::SP),
-                                        std::make_unique<T86::IntImmediate>(ctx.allocated_space_for_variables)));
+    ctx.addFrameAllocation(ctx.allocated_space_for_variables);
+    if (ctx.allocated_space_for_variables)
+        ctx.addInstruction(T86::Instruction(T86::Instruction::SUB, T86::Register(T86::Register::SP),
+                                            T86::IntImmediate(ctx.allocated_space_for_variables)));
+
+    // arguments leave the registers of the convention at once, calls reuse them
+    for (auto &i: arguments)
+        i->generateT86(ctx);
 
 
     for (auto &i: allocas)
@@ -364,22 +662,38 @@ void IR::IRFunc::generateT86(T86::Context &ctx) {
 }
 
 void IR::IRProgram::generateT86(T86::Context &ctx) {
-    // pre init
+    generateEntry(ctx);
+    generateFunctions(ctx);
+    ctx.finishCallsAndJmps();
+}
 
-    // TODO later -- .data segment
+void IR::IRProgram::generateEntry(T86::Context &ctx) {
+    for (auto &i: globalDecl)
+        i->generateT86(ctx);
 
     // Pre init of any program;
-    // call main and afet ret -- halt
-    auto place_of_main = std::make_unique<T86::IntImmediate>();
-    ctx.addFunctionCall("main", place_of_main.get());
-
-    ctx.addInstruction(T86::Instruction(T86::Instruction::CALL, std::move(place_of_main)));
+    // compute the dynamic values of the globals, call main and afet ret -- halt
+    for (auto &i: functions)
+        if (auto func = dynamic_cast<IRFunc *>(i.get()); func && func->getName() == init_function) {
+            ctx.addFunctionCall(init_function);
+            ctx.addInstruction(T86::Instruction(T86::Instruction::CALL, T86::IntImmediate()));
+        }
+    ctx.addFunctionCall("main");
+    ctx.addInstruction(T86::Instruction(T86::Instruction::CALL, T86::IntImmediate()));
     ctx.addInstruction(T86::Instruction(T86::Instruction::HALT));
+}
 
+void IR::IRProgram::generateFunctions(T86::Context &ctx) {
+    // callers have to know, which functions return a value, before they are generated
     for (auto &i: functions)
-        i->generateT86(ctx);
+        if (auto func = dynamic_cast<IRFunc *>(i.get()); func && func->returnsValue())
+            ctx.addReturningFunction(func->getName());
 
-    ctx.finishCallsAndJmps();
+    for (auto &i: functions) {
+        auto func = dynamic_cast<IRFunc *>(i.get());
+        Profiler::Span span(func ? ctx.profiler : nullptr, func ? func->getName() : "");
+        i->generateT86(ctx);
+    }
 }
 
 void IR::IRComment::generateT86(T86::Context &ctx) {
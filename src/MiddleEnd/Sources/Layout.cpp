@@ -0,0 +1,130 @@
+#include "Layout.h"
+
+void IR::BlockLayout::run(IRProgram &program) {
+    for (auto &i: *program.getLinkToFunctions())
+        if (auto func = dynamic_cast<IRFunc *>(i.get()))
+            layoutFunction(*func);
+}
+
+void IR::BlockLayout::layoutFunction(IRFunc &function) {
+    auto &body = *function.getLinkToBody();
+    if (body.empty())
+        return;
+
+    // block starts by the label or right after the branch and the return
+    std::vector<Block> blocks;
+    std::map<Value *, std::size_t> block_of_label;
+    bool starts = true;
+    for (std::size_t i = 0; i < body.size(); ++i) {
+        auto instruction = body[i].get();
+        if (starts || dynamic_cast<IRLabel *>(instruction))
+            blocks.push_back({i, i});
+        if (dynamic_cast<IRLabel *>(instruction))
+            block_of_label[instruction] = blocks.size() - 1;
+        blocks.back().end = i + 1;
+
+        starts = dynamic_cast<IRBranch *>(instruction) || dynamic_cast<IRRet *>(instruction);
+    }
+
+    auto n = blocks.size();
+    for (std::size_t b = 0; b < n; ++b) {
+        auto last = body[blocks[b].end - 1].get();
+        if (auto branch = dynamic_cast<IRBranch *>(last)) {
+            auto cond = branch->getCond();
+            // condition decided by the range analysis leaves the other side unreachable
+            if (cond && cond->range.isConstant())
+                blocks[b].successors.emplace_back(
+                        block_of_label.at(cond->range.min == 1 ? branch->getBrTaken() : branch->getBrNTaken()));
+            else {
+                // taken branch is the body of the if and of the loop
+                blocks[b].successors.emplace_back(block_of_label.at(branch->getBrTaken()));
+                if (cond)
+                    blocks[b].successors.emplace_back(block_of_label.at(branch->getBrNTaken()));
+            }
+        } else if (!dynamic_cast<IRRet *>(last)) {
+            blocks[b].falls_through = true;
+            if (b + 1 < n)
+                blocks[b].successors.emplace_back(b + 1);
+        }
+    }
+
+    std::vector<bool> reachable(n);
+    std::vector<std::size_t> stack = {0};
+    reachable[0] = true;
+    while (!stack.empty()) {
+        auto b = stack.back();
+        stack.pop_back();
+        for (auto s: blocks[b].successors)
+            if (!reachable[s]) {
+                reachable[s] = true;
+                stack.push_back(s);
+            }
+    }
+
+    // blocks, which are entered by falling through, stay glued to their predecessor. The one, which falls
+    // out of the function, has to stay the last
+    std::vector<bool> glued(n);
+    std::size_t last_head = n;
+    for (std::size_t b = 0; b < n; ++b) {
+        if (!reachable[b] || !blocks[b].falls_through)
+            continue;
+        if (b + 1 < n)
+            glued[b + 1] = true;
+        else {
+            last_head = b;
+            while (glued[last_head])
+                --last_head;
+        }
+    }
+    // nothing can follow the function, which falls out of its first chain
+    if (last_head == 0)
+        return;
+
+    // predecessors, which are not placed yet
+    std::vector<std::size_t> waiting(n);
+    for (std::size_t b = 0; b < n; ++b)
+        if (reachable[b])
+            for (auto s: blocks[b].successors)
+                ++waiting[s];
+
+    std::vector<std::size_t> order;
+    std::vector<bool> placed(n);
+    auto place_chain = [&](std::size_t head) {
+        for (auto b = head;; ++b) {
+            placed[b] = true;
+            order.emplace_back(b);
+            for (auto s: blocks[b].successors)
+                --waiting[s];
+            if (!blocks[b].falls_through || b + 1 == n)
+                return;
+        }
+    };
+    auto candidate = [&](std::size_t b) {
+        return reachable[b] && !placed[b] && !glued[b] && b != last_head;
+    };
+
+    place_chain(0);
+    while (true) {
+        auto next = n;
+        // join is placed after all its predecessors, so the successor does not steal it from the others
+        for (auto s: blocks[order.back()].successors)
+            if (candidate(s) && !waiting[s]) {
+                next = s;
+                break;
+            }
+        for (std::size_t b = 0; b < n && next == n; ++b)
+            if (candidate(b))
+                next = b;
+        if (next == n)
+            break;
+        place_chain(next);
+    }
+    if (last_head < n)
+        place_chain(last_head);
+
+    std::vector<std::unique_ptr<Value>> new_body;
+    for (auto b: order)
+        for (auto i = blocks[b].begin; i < blocks[b].end; ++i)
+            new_body.emplace_back(std::move(body[i]));
+    body = std::move(new_body);
+}
@@ -0,0 +1,308 @@
+#include "ModRef.h"
+
+void IR::ModRefAnalysis::run(IRProgram &program) {
+    for (auto &i: *program.getLinkToFunctions())
+        if (auto func = dynamic_cast<IRFunc *>(i.get()))
+            functions[func->getName()] = func;
+
+    for (auto &[_, func]: functions)
+        placeResult(*func);
+
+    for (auto &[_, func]: functions)
+        runFunction(*func);
+}
+
+void IR::ModRefAnalysis::runStreamed(IRFunc &function) {
+    functions = {{function.getName(), &function}};
+    placeResult(function);
+    runFunction(function);
+
+    auto &summary = summaries[function.getName()];
+    for (std::size_t arg = 0; arg < function.getLinkToArgs()->size(); ++arg)
+        summary.push_back(readOnly(function, arg));
+
+    // the function is freed after this
+    functions.clear();
+    users.clear();
+    read_only.clear();
+}
+
+const std::map<std::string, std::vector<bool>> &IR::ModRefAnalysis::getSummaries() {
+    return summaries;
+}
+
+void IR::ModRefAnalysis::addSummary(const std::string &name, const std::vector<bool> &summary) {
+    summaries[name] = summary;
+}
+
+IR::ModRefAnalysis::Users IR::ModRefAnalysis::findUsers(IRFunc &function) {
+    Users res;
+    for (auto &i: *function.getLinkToBody())
+        for (auto operand: i->getOperands())
+            res[operand].emplace_back(i.get());
+    return res;
+}
+
+bool IR::ModRefAnalysis::readOnly(IRFunc &function, std::size_t arg) {
+    auto key = std::make_pair(&function, arg);
+    auto found = read_only.find(key);
+    if (found != read_only.end())
+        return found->second;
+
+    if (!users.count(&function))
+        users[&function] = findUsers(function);
+    auto &function_users = users[&function];
+
+    auto argument = (*function.getLinkToArgs())[arg].get();
+    bool res = true;
+    for (auto user: function_users[argument]) {
+        // the address is kept in the variable of the argument, which is only loaded then
+        auto store = dynamic_cast<IRStore *>(user);
+        auto variable = store ? dynamic_cast<IRAlloca *>(store->getStoreWhere()) : nullptr;
+        if (!variable || store->getStoreWhat() != argument) {
+            res = res && onlyRead(argument, function_users);
+            continue;
+        }
+        for (auto access: function_users[variable]) {
+            if (access == store)
+                continue;
+            if (!dynamic_cast<IRLoad *>(access) || !onlyRead(access, function_users))
+                res = false;
+        }
+    }
+
+    read_only[key] = res;
+    return res;
+}
+
+bool IR::ModRefAnalysis::onlyRead(Value *address, Users &function_users) {
+    for (auto user: function_users[address]) {
+        if (dynamic_cast<IRLoad *>(user))
+            continue;
+        if (auto copy = dynamic_cast<IRMemCopy *>(user)) {
+            if (copy->getCopyTo() == address)
+                return false;
+            continue;
+        }
+        if (dynamic_cast<IRMembCall *>(user) && onlyRead(user, function_users))
+            continue;
+        return false;
+    }
+    return true;
+}
+
+bool IR::ModRefAnalysis::staysLocal(Value *object, Users &function_users) {
+    for (auto user: function_users[object]) {
+        if (dynamic_cast<IRLoad *>(user) || dynamic_cast<IRMemCopy *>(user))
+            continue;
+        if (auto store = dynamic_cast<IRStore *>(user)) {
+            if (store->getStoreWhat() == object)
+                return false;
+            continue;
+        }
+        if (dynamic_cast<IRMembCall *>(user) && staysLocal(user, function_users))
+            continue;
+        return false;
+    }
+    return true;
+}
+
+void IR::ModRefAnalysis::collectMembers(Value *object, Users &function_users, std::vector<Value *> &res) {
+    res.emplace_back(object);
+    for (auto user: function_users[object])
+        if (dynamic_cast<IRMembCall *>(user))
+            collectMembers(user, function_users, res);
+}
+
+void IR::ModRefAnalysis::placeResult(IRFunc &function) {
+    auto &arguments = *function.getLinkToArgs();
+    if (arguments.empty())
+        return;
+    auto &body = *function.getLinkToBody();
+    auto function_users = findUsers(function);
+
+    // address of the result is kept in the variable, which is only loaded by the returns
+    auto result = arguments.back().get();
+    if (function_users[result].size() != 1)
+        return;
+    auto store = dynamic_cast<IRStore *>(function_users[result][0]);
+    if (!store || store->getStoreWhat() != result || !dynamic_cast<IRAlloca *>(store->getStoreWhere()))
+        return;
+    auto slot = store->getStoreWhere();
+
+    // every return copies the same variable out
+    IRAlloca *variable = nullptr;
+    std::set<Value *> copies;
+    for (std::size_t i = 0; i < body.size(); ++i) {
+        if (!dynamic_cast<IRRet *>(body[i].get()))
+            continue;
+        auto copy = i ? dynamic_cast<IRMemCopy *>(body[i - 1].get()) : nullptr;
+        auto load = copy ? dynamic_cast<IRLoad *>(copy->getCopyTo()) : nullptr;
+        auto from = copy ? dynamic_cast<IRAlloca *>(copy->getCopyFrom()) : nullptr;
+        if (!load || load->getPointer() != slot || !from || (variable && variable != from))
+            return;
+        variable = from;
+        copies.insert(copy);
+        copies.insert(load);
+    }
+    if (!variable || variable->isPlaced())
+        return;
+
+    for (auto user: function_users[slot])
+        if (user != store && !copies.count(user))
+            return;
+
+    variable->placeAt(result);
+    body.erase(std::remove_if(body.begin(), body.end(), [&](auto &instruction) {
+        return copies.count(instruction.get());
+    }), body.end());
+}
+
+IR::IRAlloca *IR::ModRefAnalysis::rootOf(Value *object) {
+    while (auto member = dynamic_cast<IRMembCall *>(object))
+        object = member->getOperands()[0];
+    return dynamic_cast<IRAlloca *>(object);
+}
+
+void IR::ModRefAnalysis::forwardResults(IRFunc &function, std::set<Value *> &removed) {
+    auto &body = *function.getLinkToBody();
+    auto function_users = findUsers(function);
+
+    for (std::size_t i = 0; i + 1 < body.size(); ++i) {
+        auto call = dynamic_cast<IRCall *>(body[i].get());
+        if (!call)
+            continue;
+        auto arguments = call->getOperands();
+        if (arguments.empty())
+            continue;
+
+        // temporary, which gets the result and is copied right after the call
+        auto temporary = dynamic_cast<IRAlloca *>(arguments.back());
+        auto copy = dynamic_cast<IRMemCopy *>(body[i + 1].get());
+        if (!temporary || !copy || copy->getCopyFrom() != temporary || function_users[temporary].size() != 2 ||
+            temporary->isPlaced())
+            continue;
+
+        // the destination is a local object, which nobody else can see during the call
+        auto destination = copy->getCopyTo();
+        auto root = rootOf(destination);
+        if (!root || root == temporary || !staysLocal(root, function_users))
+            continue;
+        if (destination != root) {
+            auto defined = std::find_if(body.begin(), body.begin() + i, [&](auto &instruction) {
+                return instruction.get() == destination;
+            });
+            if (defined == body.begin() + i)
+                continue;
+        }
+
+        // the call does not read the object through the other arguments
+        std::vector<Value *> members;
+        collectMembers(root, function_users, members);
+        bool passed = false;
+        for (auto argument: arguments)
+            if (std::find(members.begin(), members.end(), argument) != members.end())
+                passed = true;
+        if (passed)
+            continue;
+
+        call->setArg(arguments.size() - 1, destination);
+        removed.insert(copy);
+        removed.insert(temporary);
+    }
+}
+
+long long IR::ModRefAnalysis::argumentsOf(const std::string &name) {
+    auto target = functions.find(name);
+    if (target != functions.end())
+        return (long long) target->second->getLinkToArgs()->size();
+    auto summary = summaries.find(name);
+    if (summary != summaries.end())
+        return (long long) summary->second.size();
+    return -1;
+}
+
+bool IR::ModRefAnalysis::readOnly(const std::string &name, std::size_t arg) {
+    auto target = functions.find(name);
+    if (target != functions.end())
+        return readOnly(*target->second, arg);
+    return summaries[name][arg];
+}
+
+void IR::ModRefAnalysis::passOriginals(IRFunc &function, std::set<Value *> &removed) {
+    auto &body = *function.getLinkToBody();
+    auto function_users = findUsers(function);
+
+    for (std::size_t i = 0; i < body.size(); ++i) {
+        auto call = dynamic_cast<IRCall *>(body[i].get());
+        if (!call)
+            continue;
+        auto arguments = call->getOperands();
+        if ((long long) arguments.size() != argumentsOf(call->getFunctionName()))
+            continue;
+        for (std::size_t arg = 0; arg < arguments.size(); ++arg) {
+            // temporary, which is filled by the copy and passed to this call only
+            auto temporary = dynamic_cast<IRAlloca *>(arguments[arg]);
+            if (!temporary || function_users[temporary].size() != 2)
+                continue;
+            auto copy = dynamic_cast<IRMemCopy *>(function_users[temporary][0]);
+            if (!copy || copy->getCopyTo() != temporary || function_users[temporary][1] != call)
+                continue;
+
+            auto original = dynamic_cast<IRAlloca *>(copy->getCopyFrom());
+            if (!original || !staysLocal(original, function_users) || !readOnly(call->getFunctionName(), arg))
+                continue;
+
+            // the original must not change between the copy and the call
+            std::vector<Value *> members;
+            collectMembers(original, function_users, members);
+            std::size_t place = i;
+            while (body[place].get() != copy)
+                --place;
+            bool written = false;
+            for (auto k = place + 1; k < i; ++k) {
+                auto store = dynamic_cast<IRStore *>(body[k].get());
+                auto other_copy = dynamic_cast<IRMemCopy *>(body[k].get());
+                for (auto member: members)
+                    if ((store && store->getStoreWhere() == member) ||
+                        (other_copy && other_copy->getCopyTo() == member))
+                        written = true;
+            }
+            // the called function may write the original through the other argument
+            for (auto argument: arguments)
+                if (std::find(members.begin(), members.end(), argument) != members.end())
+                    written = true;
+            if (written)
+                continue;
+
+            call->setArg(arg, original);
+            arguments[arg] = original;
+            removed.insert(copy);
+            removed.insert(temporary);
+        }
+    }
+}
+
+void IR::ModRefAnalysis::runFunction(IRFunc &function) {
+    auto &body = *function.getLinkToBody();
+
+    std::set<Value *> removed;
+    forwardResults(function, removed);
+    if (!removed.empty()) {
+        body.erase(std::remove_if(body.begin(), body.end(), [&](auto &instruction) {
+            return removed.count(instruction.get());
+        }), body.end());
+    }
+    passOriginals(function, removed);
+
+    if (removed.empty())
+        return;
+
+    body.erase(std::remove_if(body.begin(), body.end(), [&](auto &instruction) {
+        return removed.count(instruction.get());
+    }), body.end());
+    auto &allocas = *function.getLinkToAllocas();
+    allocas.erase(std::remove_if(allocas.begin(), allocas.end(), [&](auto &alloca) {
+        return removed.count(alloca.get());
+    }), allocas.end());
+}
@@ -0,0 +1,318 @@
+#include "Range.h"
+
+void IR::RangeAnalysis::run(IRProgram &program) {
+    std::vector<IRFunc *> program_functions;
+    for (auto &i: *program.getLinkToFunctions())
+        if (auto func = dynamic_cast<IRFunc *>(i.get())) {
+            program_functions.emplace_back(func);
+            functions[func->getName()] = func;
+        }
+
+    for (auto func: program_functions)
+        findSlots(*func);
+
+    // arguments of the function are known, if every call passes all of them
+    std::set<IRFunc *> unknown;
+    for (auto func: program_functions)
+        for (auto &i: *func->getLinkToBody())
+            if (auto call = dynamic_cast<IRCall *>(i.get())) {
+                auto target = functions.find(call->getFunctionName());
+                if (target == functions.end())
+                    continue;
+                if (call->getOperands().size() == target->second->getLinkToArgs()->size())
+                    called.insert(target->second);
+                else
+                    unknown.insert(target->second);
+            }
+    for (auto func: unknown)
+        called.erase(func);
+    // the other parts may call any of them
+    if (part)
+        called.clear();
+
+    for (auto func: program_functions) {
+        for (auto &i: *func->getLinkToArgs())
+            i->range = called.count(func) ? empty() : full();
+        for (auto &i: *func->getLinkToBody())
+            i->range = empty();
+        results[func] = empty();
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto func: program_functions)
+            changed |= analyseFunction(*func);
+        ++round;
+    }
+
+    // values, which have not been reached, can be anything
+    for (auto func: program_functions) {
+        for (auto &i: *func->getLinkToArgs())
+            if (isEmpty(i->range))
+                i->range = full();
+        for (auto &i: *func->getLinkToBody())
+            if (isEmpty(i->range))
+                i->range = full();
+    }
+}
+
+void IR::RangeAnalysis::runPart(IRProgram &program) {
+    part = true;
+    run(program);
+}
+
+IR::Range IR::RangeAnalysis::empty() {
+    return {LLONG_MAX, LLONG_MIN};
+}
+
+bool IR::RangeAnalysis::isEmpty(const Range &range) {
+    return range.min > range.max;
+}
+
+IR::Range IR::RangeAnalysis::full() {
+    return {LLONG_MIN, LLONG_MAX};
+}
+
+IR::Range IR::RangeAnalysis::join(const Range &first, const Range &second) {
+    return {std::min(first.min, second.min), std::max(first.max, second.max)};
+}
+
+bool IR::RangeAnalysis::collect(Range &place, const Range &values) {
+    if (isEmpty(values))
+        return false;
+
+    auto joined = join(place, values);
+    if (joined.min == place.min && joined.max == place.max)
+        return false;
+
+    // the loops would raise the bound by one in each round
+    if (!isEmpty(place) && round > 2) {
+        if (joined.min < place.min)
+            joined.min = LLONG_MIN;
+        if (joined.max > place.max)
+            joined.max = LLONG_MAX;
+    }
+    place = joined;
+    return true;
+}
+
+void IR::RangeAnalysis::findSlots(IRFunc &function) {
+    std::set<Value *> escaped;
+    for (auto &i: *function.getLinkToBody()) {
+        auto load = dynamic_cast<IRLoad *>(i.get());
+        auto store = dynamic_cast<IRStore *>(i.get());
+        for (auto operand: i->getOperands()) {
+            auto alloca = dynamic_cast<IRAlloca *>(operand);
+            if (!alloca)
+                continue;
+            if (load || (store && operand == store->getStoreWhere() && operand != store->getStoreWhat())) {
+                if (slots.count(alloca))
+                    continue;
+                // the default value is there before the first store
+                auto basic = alloca->getBasicValue();
+                if (auto constant = dynamic_cast<IntConst *>(basic))
+                    slots[alloca] = {constant->getValue(), constant->getValue()};
+                else
+                    slots[alloca] = basic ? full() : empty();
+            } else
+                escaped.insert(alloca);
+        }
+    }
+
+    for (auto alloca: escaped)
+        slots.erase(alloca);
+}
+
+bool IR::RangeAnalysis::analyseFunction(IRFunc &function) {
+    bool changed = false;
+    for (auto &i: *function.getLinkToBody()) {
+        auto value = i.get();
+
+        auto range = transfer(value);
+        if (range.min != value->range.min || range.max != value->range.max) {
+            value->range = range;
+            changed = true;
+        }
+
+        if (auto store = dynamic_cast<IRStore *>(value)) {
+            auto slot = slots.find(store->getStoreWhere());
+            if (slot != slots.end())
+                changed |= collect(slot->second, store->getStoreWhat()->range);
+        } else if (auto ret = dynamic_cast<IRRet *>(value)) {
+            if (ret->getRetVal())
+                changed |= collect(results[&function], ret->getRetVal()->range);
+        } else if (auto call = dynamic_cast<IRCall *>(value)) {
+            auto target = functions.find(call->getFunctionName());
+            if (target == functions.end() || !called.count(target->second))
+                continue;
+            auto passed = call->getOperands();
+            auto &arguments = *target->second->getLinkToArgs();
+            for (std::size_t arg = 0; arg < passed.size(); ++arg)
+                changed |= collect(arguments[arg]->range, passed[arg]->range);
+        }
+    }
+    return changed;
+}
+
+IR::Range IR::RangeAnalysis::transfer(Value *value) {
+    if (auto constant = dynamic_cast<IntConst *>(value))
+        return {constant->getValue(), constant->getValue()};
+
+    if (auto operation = dynamic_cast<IRArithOp *>(value))
+        return arithmetic(operation);
+
+    // integers are kept in the whole words, so the conversion between them keeps the value
+    if (auto cast = dynamic_cast<IRCast *>(value)) {
+        if (dynamic_cast<FloatType *>(cast->getTypeTo()) || dynamic_cast<FloatType *>(cast->getTypeFrom()))
+            return full();
+        return cast->getExpr()->range;
+    }
+
+    if (auto load = dynamic_cast<IRLoad *>(value)) {
+        auto slot = slots.find(load->getPointer());
+        if (slot != slots.end())
+            return slot->second;
+        return full();
+    }
+
+    if (auto call = dynamic_cast<IRCall *>(value)) {
+        auto target = functions.find(call->getFunctionName());
+        if (target != functions.end())
+            return results[target->second];
+        return full();
+    }
+
+    return full();
+}
+
+IR::Range IR::RangeAnalysis::arithmetic(IRArithOp *operation) {
+    auto op = operation->getOperator();
+    if (op == IRArithOp::EQ || op == IRArithOp::NE || op == IRArithOp::GT || op == IRArithOp::GE ||
+        op == IRArithOp::LT || op == IRArithOp::LE)
+        return compare(operation);
+
+    if (dynamic_cast<FloatType *>(operation->getTypeOfResult()))
+        return full();
+
+    auto left = operation->getLeft()->range, right = operation->getRight()->range;
+    if (isEmpty(left) || isEmpty(right))
+        return empty();
+
+    Range res;
+    switch (op) {
+        case IRArithOp::PLUS:
+            if (__builtin_add_overflow(left.min, right.min, &res.min) ||
+                __builtin_add_overflow(left.max, right.max, &res.max))
+                return full();
+            return res;
+
+        case IRArithOp::MINUS:
+            if (__builtin_sub_overflow(left.min, right.max, &res.min) ||
+                __builtin_sub_overflow(left.max, right.min, &res.max))
+                return full();
+            return res;
+
+        case IRArithOp::MUL: {
+            long long products[4];
+            if (__builtin_mul_overflow(left.min, right.min, &products[0]) ||
+                __builtin_mul_overflow(left.min, right.max, &products[1]) ||
+                __builtin_mul_overflow(left.max, right.min, &products[2]) ||
+                __builtin_mul_overflow(left.max, right.max, &products[3]))
+                return full();
+            return {*std::min_element(products, products + 4), *std::max_element(products, products + 4)};
+        }
+
+        case IRArithOp::DIV:
+            // division by the constant is monotone
+            if (right.isConstant() && right.min != 0 && !(right.min == -1 && left.min == LLONG_MIN)) {
+                auto first = left.min / right.min, second = left.max / right.min;
+                return {std::min(first, second), std::max(first, second)};
+            }
+            if (left.nonNegative() && right.min > 0)
+                return {0, left.max};
+            return full();
+
+        case IRArithOp::MOD: {
+            if (!right.isConstant() || right.min == 0)
+                return full();
+            if (left.isConstant() && right.min != -1)
+                return {left.min % right.min, left.min % right.min};
+            // remainder takes the sign of the dividend and is smaller than the divisor
+            auto bound = right.min == LLONG_MIN ? LLONG_MAX : std::abs(right.min) - 1;
+            if (left.nonNegative())
+                return {0, std::min(left.max, bound)};
+            if (left.max <= 0)
+                return {std::max(left.min, -bound), 0};
+            return {-bound, bound};
+        }
+
+        case IRArithOp::AND:
+        case IRArithOp::BINAND:
+            if (left.isConstant() && right.isConstant())
+                return {left.min & right.min, left.min & right.min};
+            if (left.nonNegative() && right.nonNegative())
+                return {0, std::min(left.max, right.max)};
+            if (left.nonNegative())
+                return {0, left.max};
+            if (right.nonNegative())
+                return {0, right.max};
+            return full();
+
+        default: {
+            // OR, BINOR, XOR
+            if (left.isConstant() && right.isConstant()) {
+                auto exact = op == IRArithOp::XOR ? left.min ^ right.min : left.min | right.min;
+                return {exact, exact};
+            }
+            if (!left.nonNegative() || !right.nonNegative())
+                return full();
+            // no bit above the highest one of the operands
+            long long mask = 0;
+            while (mask < std::max(left.max, right.max))
+                mask = mask * 2 + 1;
+            return {0, mask};
+        }
+    }
+}
+
+IR::Range IR::RangeAnalysis::compare(IRArithOp *operation) {
+    auto left = operation->getLeft()->range, right = operation->getRight()->range;
+    if (operation->getLeft()->isFloat() || operation->getRight()->isFloat())
+        return {0, 1};
+    if (isEmpty(left) || isEmpty(right))
+        return empty();
+
+    bool always = false, never = false;
+    switch (operation->getOperator()) {
+        case IRArithOp::EQ:
+        case IRArithOp::NE:
+            always = left.isConstant() && right.isConstant() && left.min == right.min;
+            never = left.max < right.min || right.max < left.min;
+            if (operation->getOperator() == IRArithOp::NE)
+                std::swap(always, never);
+            break;
+        case IRArithOp::LT:
+            always = left.max < right.min;
+            never = left.min >= right.max;
+            break;
+        case IRArithOp::LE:
+            always = left.max <= right.min;
+            never = left.min > right.max;
+            break;
+        case IRArithOp::GT:
+            always = left.min > right.max;
+            never = left.max <= right.min;
+            break;
+        default:
+            always = left.min >= right.max;
+            never = left.max < right.min;
+            break;
+    }
+
+    if (always)
+        return {1, 1};
+    if (never)
+        return {0, 0};
+    return {0, 1};
+}